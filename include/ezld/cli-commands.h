@@ -22,5 +22,26 @@ void ezld_clicmd_version(ezld_config_t config);
 
 void ezld_clicmd_entrysym(ezld_config_t *config, const char *next);
 void ezld_clicmd_section(ezld_config_t *config, const char *next);
+void ezld_clicmd_loadaddr(ezld_config_t *config, const char *next);
+void ezld_clicmd_secmap(ezld_config_t *config, const char *next);
 void ezld_clicmd_align(ezld_config_t *config, const char *next);
+void ezld_clicmd_compact(ezld_config_t *config, const char *next);
+void ezld_clicmd_hdrload(ezld_config_t *config, const char *next);
+void ezld_clicmd_sortalign(ezld_config_t *config, const char *next);
+void ezld_clicmd_relocatable(ezld_config_t *config, const char *next);
+void ezld_clicmd_emitrelocs(ezld_config_t *config, const char *next);
+void ezld_clicmd_discardall(ezld_config_t *config, const char *next);
+void ezld_clicmd_symhash(ezld_config_t *config, const char *next);
+void ezld_clicmd_stripdebug(ezld_config_t *config, const char *next);
+void ezld_clicmd_stripall(ezld_config_t *config, const char *next);
+void ezld_clicmd_discardsec(ezld_config_t *config, const char *next);
+void ezld_clicmd_staticpie(ezld_config_t *config, const char *next);
+void ezld_clicmd_buildid(ezld_config_t *config, const char *next);
+void ezld_clicmd_compressdebug(ezld_config_t *config, const char *next);
+void ezld_clicmd_oformat(ezld_config_t *config, const char *next);
+void ezld_clicmd_compress(ezld_config_t *config, const char *next);
+void ezld_clicmd_imagecrc(ezld_config_t *config, const char *next);
 void ezld_clicmd_output(ezld_config_t *config, const char *next);
+void ezld_clicmd_symorder(ezld_config_t *config, const char *next);
+void ezld_clicmd_cgsort(ezld_config_t *config, const char *next);
+void ezld_clicmd_cgprofile(ezld_config_t *config, const char *next);
@@ -0,0 +1,56 @@
+// MIT License
+//
+// Copyright (c) 2025 - 2026 Alessandro Salerno
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Matches of the encoder reach at most 32 KiB back, and are looked up by the
+// hash of their first 3 bytes
+#define EZLD_DEFLATE_WINDOW    32768
+#define EZLD_DEFLATE_HASH_BITS 15
+
+/**
+ * @brief Tables used by the compressor to find matches. Positions are stored
+ * plus one, so that 0 means unseen
+ */
+typedef struct ezld_deflate_tabs {
+    /** Last position with each 3-byte hash */
+    size_t dt_head[1 << EZLD_DEFLATE_HASH_BITS];
+    /** Earlier position with the same hash as each position of the window */
+    size_t dt_prev[EZLD_DEFLATE_WINDOW];
+} ezld_deflate_tabs_t;
+
+size_t ezld_deflate_bound(size_t len);
+// Compresses `len` bytes of `src` to a zlib stream in `dst`, which must be at
+// least `ezld_deflate_bound(len)` bytes long, and returns its size. Nothing is
+// allocated, so this can run in `ezld_runtime_parallel_for`
+size_t ezld_deflate_zlib(uint8_t             *dst,
+                         const uint8_t       *src,
+                         size_t               len,
+                         ezld_deflate_tabs_t *tabs);
+bool   ezld_inflate_zlib(uint8_t       *out,
+                         size_t         outlen,
+                         const uint8_t *in,
+                         size_t         inlen);
@@ -0,0 +1,35 @@
+// MIT License
+//
+// Copyright (c) 2025 - 2026 Alessandro Salerno
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+void     ezld_hash_crc32_tables(uint32_t tables[16][256], uint32_t poly);
+uint32_t ezld_hash_crc32_update(uint32_t       tables[16][256],
+                                uint32_t       crc,
+                                const uint8_t *data,
+                                size_t         len);
+uint64_t ezld_hash_xxh64(const uint8_t *data, size_t len, uint64_t seed);
+// Stores the 20-byte SHA-1 digest of `len` bytes of `data` in `digest`
+void     ezld_hash_sha1(const uint8_t *data, size_t len, uint8_t *digest);
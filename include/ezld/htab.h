@@ -0,0 +1,61 @@
+// MIT License
+//
+// Copyright (c) 2025 - 2026 Alessandro Salerno
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct ezld_htab_ent {
+    /** Pointer to the key bytes. The table does not copy keys, so the buffer
+     * must outlive the table. `NULL` marks an empty slot */
+    const void *he_key;
+    /** Length of the key in bytes */
+    size_t he_keylen;
+    /** Cached hash of the key */
+    size_t he_hash;
+    /** Value associated with the key */
+    size_t he_value;
+} ezld_htab_ent_t;
+
+typedef struct ezld_htab {
+    ezld_htab_ent_t *ht_buf;
+    size_t           ht_len;
+    size_t           ht_cap;
+} ezld_htab_t;
+
+#define ezld_htab_new() {.ht_buf = NULL, .ht_len = 0, .ht_cap = 0}
+#define ezld_htab_init(htab) \
+    (htab).ht_buf = NULL, (htab).ht_len = 0, (htab).ht_cap = 0
+
+size_t ezld_htab_hash(const void *key, size_t keylen);
+bool   ezld_htab_get(ezld_htab_t *htab,
+                     const void  *key,
+                     size_t       keylen,
+                     size_t      *value);
+// Inserts `*value` under `key` if the key is not present yet and returns
+// `false`. Otherwise, stores the existing value in `*value` and returns `true`
+bool   ezld_htab_put(ezld_htab_t *htab,
+                     const void  *key,
+                     size_t       keylen,
+                     size_t      *value);
+void   ezld_htab_free(ezld_htab_t *htab);
@@ -24,21 +24,63 @@
 
 #include <ezld/array.h>
 #include <musl/elf.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 
+#define EZLD_OFORMAT_ELF    0
+#define EZLD_OFORMAT_BINARY 1
+#define EZLD_OFORMAT_IHEX   2
+#define EZLD_OFORMAT_SREC   3
+
+#define EZLD_IMAGE_CRC32  0
+#define EZLD_IMAGE_CRC32C 1
+
+#define EZLD_BUILD_ID_NONE 0
+#define EZLD_BUILD_ID_FAST 1
+#define EZLD_BUILD_ID_SHA1 2
+#define EZLD_BUILD_ID_UUID 3
+
 typedef struct ezld_sec_cfg {
     const char *sc_name;
     size_t      sc_vaddr;
 } ezld_sec_cfg_t;
 
+typedef struct ezld_sec_map {
+    const char *sm_pattern;
+    const char *sm_output;
+} ezld_sec_map_t;
+
 typedef struct ezld_config {
     ezld_array(ezld_sec_cfg_t) cfg_sections;
+    ezld_array(ezld_sec_cfg_t) cfg_loadaddrs;
+    ezld_array(ezld_sec_map_t) cfg_secmaps;
+    ezld_array(const char *) cfg_discards;
     ezld_array(const char *) cfg_objpaths;
     size_t      cfg_segalign;
     const char *cfg_entrysym;
     const char *cfg_outpath;
+    const char *cfg_symorderpath;
+    const char *cfg_cgprofile;
+    bool        cfg_cgsort;
+    bool        cfg_compact;
+    bool        cfg_hdrload;
+    bool        cfg_sortalign;
+    bool        cfg_relocatable;
+    bool        cfg_emitrelocs;
+    bool        cfg_discardlocals;
+    bool        cfg_stripdebug;
+    bool        cfg_stripall;
+    bool        cfg_symhash;
+    bool        cfg_staticpie;
+    int         cfg_oformat;
+    bool        cfg_compress;
+    size_t      cfg_compressaddr;
+    const char *cfg_crcsym;
+    int         cfg_crcalgo;
+    int         cfg_buildid;
+    bool        cfg_compressdebug;
 } ezld_config_t;
 
 void ezld_link(ezld_config_t params);
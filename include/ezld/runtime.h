@@ -23,6 +23,7 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #define EZLD_ECODE_NOPARAM  -1
@@ -75,3 +76,8 @@ void  ezld_runtime_write_exact_at(void       *buf,
 void  ezld_runtime_seek_end(const char *filename, FILE *file);
 void *ezld_runtime_realloc(void *buf, size_t size);
 bool  ezld_runtime_is_big_endian(void);
+char *ezld_runtime_read_file(const char *filename, size_t *size);
+bool  ezld_runtime_glob_match(const char *pattern, const char *str);
+void  ezld_runtime_parallel_for(size_t num,
+                                void (*fn)(void *ctx, size_t ndx),
+                                void  *ctx);
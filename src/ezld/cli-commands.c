@@ -57,7 +57,7 @@ static size_t parse_digit(char digit, size_t base, size_t pos) {
     }
 
     if (!isalpha(digit)) {
-        if (digit < '0' || digit > ('0' + (char)base)) {
+        if (digit < '0' || digit >= ('0' + (char)base)) {
             ezld_runtime_exit(
                 EZLD_ECODE_BADPARAM,
                 "'%c' is not a valid input for number in base %zu",
@@ -70,14 +70,15 @@ static size_t parse_digit(char digit, size_t base, size_t pos) {
 
     char start = isupper(digit) ? 'A' : 'a';
 
-    if (digit > (start + (char)base)) {
+    // Letters stand for the digits after 9
+    if (digit - start + 10 >= (int)base) {
         ezld_runtime_exit(EZLD_ECODE_BADPARAM,
                           "'%c' is not a valid input for number in base %zu",
                           digit,
                           base);
     }
 
-    value = digit - start;
+    value = digit - start + 10;
     return value * mult;
 }
 
@@ -103,12 +104,13 @@ static size_t parse_number(const char *str) {
     }
 
     if (start >= len) {
-        return 0;
+        ezld_runtime_exit(
+            EZLD_ECODE_BADPARAM, "'%s' is not a valid number", str);
     }
 
-    for (size_t i = len - 1; i > start; i--) {
-        size_t pos = len - i - 1;
-        value += parse_digit(str[i], base, pos);
+    for (size_t i = len; i > start; i--) {
+        size_t pos = len - i;
+        value += parse_digit(str[i - 1], base, pos);
     }
 
     return value;
@@ -154,10 +156,180 @@ void ezld_clicmd_section(ezld_config_t *config, const char *next) {
     s->sc_vaddr       = parse_number(value);
 }
 
+void ezld_clicmd_loadaddr(ezld_config_t *config, const char *next) {
+    char *key = NULL, *value = NULL;
+    parse_assignment(next, &key, &value);
+
+    for (size_t i = 0; i < config->cfg_loadaddrs.len; i++) {
+        if (strcmp(config->cfg_loadaddrs.buf[i].sc_name, key) == 0) {
+            config->cfg_loadaddrs.buf[i].sc_vaddr = parse_number(value);
+            return;
+        }
+    }
+
+    ezld_sec_cfg_t *s = ezld_array_push(config->cfg_loadaddrs);
+    s->sc_name        = key;
+    s->sc_vaddr       = parse_number(value);
+}
+
+void ezld_clicmd_secmap(ezld_config_t *config, const char *next) {
+    char *key = NULL, *value = NULL;
+    parse_assignment(next, &key, &value);
+
+    ezld_sec_map_t *m = ezld_array_push(config->cfg_secmaps);
+    m->sm_pattern     = key;
+    m->sm_output      = value;
+}
+
 void ezld_clicmd_align(ezld_config_t *config, const char *next) {
     config->cfg_segalign = parse_number(next);
 }
 
+void ezld_clicmd_compact(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_compact = true;
+}
+
+void ezld_clicmd_hdrload(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_hdrload = true;
+}
+
+void ezld_clicmd_sortalign(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_sortalign = true;
+}
+
+void ezld_clicmd_relocatable(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_relocatable = true;
+}
+
+void ezld_clicmd_emitrelocs(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_emitrelocs = true;
+}
+
+void ezld_clicmd_discardall(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_discardlocals = true;
+}
+
+void ezld_clicmd_stripdebug(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_stripdebug = true;
+}
+
+void ezld_clicmd_stripall(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_stripall = true;
+}
+
+void ezld_clicmd_discardsec(ezld_config_t *config, const char *next) {
+    *ezld_array_push(config->cfg_discards) = next;
+}
+
+void ezld_clicmd_symhash(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_symhash = true;
+}
+
+void ezld_clicmd_staticpie(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_staticpie = true;
+}
+
+void ezld_clicmd_oformat(ezld_config_t *config, const char *next) {
+    static const struct {
+        const char *of_name;
+        int         of_format;
+    } formats[] = {{"elf", EZLD_OFORMAT_ELF},
+                   {"binary", EZLD_OFORMAT_BINARY},
+                   {"ihex", EZLD_OFORMAT_IHEX},
+                   {"srec", EZLD_OFORMAT_SREC}};
+
+    for (size_t i = 0; i < sizeof formats / sizeof *formats; i++) {
+        if (strcmp(formats[i].of_name, next) == 0) {
+            config->cfg_oformat = formats[i].of_format;
+            return;
+        }
+    }
+
+    ezld_runtime_exit(
+        EZLD_ECODE_BADPARAM, "unsupported output format '%s'", next);
+}
+
+void ezld_clicmd_compress(ezld_config_t *config, const char *next) {
+    config->cfg_compress     = true;
+    config->cfg_compressaddr = parse_number(next);
+}
+
+void ezld_clicmd_imagecrc(ezld_config_t *config, const char *next) {
+    char *key = NULL, *value = NULL;
+
+    if (strchr(next, '=') == NULL) {
+        config->cfg_crcsym  = next;
+        config->cfg_crcalgo = EZLD_IMAGE_CRC32;
+        return;
+    }
+
+    parse_assignment(next, &key, &value);
+    config->cfg_crcsym = key;
+
+    if (strcmp(value, "crc32") == 0) {
+        config->cfg_crcalgo = EZLD_IMAGE_CRC32;
+    } else if (strcmp(value, "crc32c") == 0) {
+        config->cfg_crcalgo = EZLD_IMAGE_CRC32C;
+    } else {
+        ezld_runtime_exit(
+            EZLD_ECODE_BADPARAM, "unsupported CRC algorithm '%s'", value);
+    }
+}
+
+void ezld_clicmd_buildid(ezld_config_t *config, const char *next) {
+    static const struct {
+        const char *bi_name;
+        int         bi_kind;
+    } kinds[] = {{"none", EZLD_BUILD_ID_NONE},
+                 {"fast", EZLD_BUILD_ID_FAST},
+                 {"sha1", EZLD_BUILD_ID_SHA1},
+                 {"uuid", EZLD_BUILD_ID_UUID}};
+
+    for (size_t i = 0; i < sizeof kinds / sizeof *kinds; i++) {
+        if (strcmp(kinds[i].bi_name, next) == 0) {
+            config->cfg_buildid = kinds[i].bi_kind;
+            return;
+        }
+    }
+
+    ezld_runtime_exit(
+        EZLD_ECODE_BADPARAM, "unsupported build ID kind '%s'", next);
+}
+
+void ezld_clicmd_compressdebug(ezld_config_t *config, const char *next) {
+    if (strcmp(next, "zlib") == 0) {
+        config->cfg_compressdebug = true;
+    } else if (strcmp(next, "none") == 0) {
+        config->cfg_compressdebug = false;
+    } else {
+        ezld_runtime_exit(
+            EZLD_ECODE_BADPARAM, "unsupported compression type '%s'", next);
+    }
+}
+
 void ezld_clicmd_output(ezld_config_t *config, const char *next) {
     config->cfg_outpath = next;
 }
+
+void ezld_clicmd_symorder(ezld_config_t *config, const char *next) {
+    config->cfg_symorderpath = next;
+}
+
+void ezld_clicmd_cgsort(ezld_config_t *config, const char *next) {
+    (void)next;
+    config->cfg_cgsort = true;
+}
+
+void ezld_clicmd_cgprofile(ezld_config_t *config, const char *next) {
+    config->cfg_cgprofile = next;
+}
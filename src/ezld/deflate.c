@@ -0,0 +1,657 @@
+// MIT License
+//
+// Copyright (c) 2025 - 2026 Alessandro Salerno
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <ezld/deflate.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Parameters of the encoder: matches are looked up through hash chains of at
+// most this many positions
+#define EZLD_DEFLATE_MAX_CHAIN 64
+#define EZLD_DEFLATE_MIN_MATCH 3
+#define EZLD_DEFLATE_MAX_MATCH 258
+// Largest number of symbols in a deflate Huffman code
+#define EZLD_DEFLATE_MAX_CODES 288
+// Largest number of bytes that can be summed before the Adler-32 sums must be
+// reduced
+#define EZLD_ADLER32_NMAX 5552
+
+/**
+ * @brief A canonical Huffman code of a deflate stream
+ */
+typedef struct ezld_huffman {
+    /** Number of codes of each length, from 0 to 15 bits */
+    uint16_t hf_count[16];
+    /** Symbols sorted by code */
+    uint16_t hf_symbol[EZLD_DEFLATE_MAX_CODES];
+} ezld_huffman_t;
+
+/**
+ * @brief State of the decompression of a zlib stream
+ */
+typedef struct ezld_inflate {
+    /** Compressed stream */
+    const uint8_t *inf_in;
+    /** Size of `inf_in` */
+    size_t inf_inlen;
+    /** Offset of the next byte of `inf_in` to be read */
+    size_t inf_inpos;
+    /** Bits read from `inf_in` and not consumed yet, least significant first */
+    uint32_t inf_bitbuf;
+    /** Number of bits in `inf_bitbuf` */
+    unsigned inf_bitcnt;
+    /** Decompressed data */
+    uint8_t *inf_out;
+    /** Size of `inf_out` */
+    size_t inf_outlen;
+    /** Number of bytes decompressed so far */
+    size_t inf_outpos;
+} ezld_inflate_t;
+
+/**
+ * @brief State of the compression of a zlib stream
+ */
+typedef struct ezld_deflate {
+    /** Compressed stream */
+    uint8_t *def_out;
+    /** Number of bytes written to `def_out` */
+    size_t def_outpos;
+    /** Bits not written to `def_out` yet, least significant first */
+    uint32_t def_bitbuf;
+    /** Number of bits in `def_bitbuf` */
+    unsigned def_bitcnt;
+} ezld_deflate_t;
+
+// Base values and extra bits of the deflate length (257-285) and distance
+// (0-29) codes
+static const uint16_t g_deflate_len_base[] = {
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t g_deflate_len_extra[] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1,
+                                              1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                                              4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t g_deflate_dist_base[] = {
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+    33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t g_deflate_dist_extra[] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+    6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+/**
+ * @brief Computes the Adler-32 checksum that ends zlib streams
+ *
+ * @param data the buffer
+ * @param len the length of the buffer
+ *
+ * @return the checksum
+ */
+static uint32_t adler32(const uint8_t *data, size_t len) {
+    uint32_t a = 1, b = 0;
+
+    while (len > 0) {
+        size_t n = (len < EZLD_ADLER32_NMAX) ? len : EZLD_ADLER32_NMAX;
+        len -= n;
+
+        for (; n > 0; n--) {
+            a += *data++;
+            b += a;
+        }
+
+        a %= 65521;
+        b %= 65521;
+    }
+
+    return (b << 16) | a;
+}
+
+/**
+ * @brief Consumes bits from a deflate stream
+ *
+ * @param inf the decompression state
+ * @param need the number of bits, at most 24
+ * @param val where to store the bits, the first one being the least significant
+ *
+ * @return `false` if the stream ends first
+ */
+static bool inf_bits(ezld_inflate_t *inf, unsigned need, uint32_t *val) {
+    while (inf->inf_bitcnt < need) {
+        if (inf->inf_inpos >= inf->inf_inlen) {
+            return false;
+        }
+
+        inf->inf_bitbuf |= (uint32_t)inf->inf_in[inf->inf_inpos++]
+                           << inf->inf_bitcnt;
+        inf->inf_bitcnt += 8;
+    }
+
+    *val = inf->inf_bitbuf & ((1u << need) - 1);
+    inf->inf_bitbuf >>= need;
+    inf->inf_bitcnt -= need;
+    return true;
+}
+
+/**
+ * @return the next symbol of the stream decoded with a Huffman code, or -1
+ * if the stream is invalid
+ */
+static int inf_decode(ezld_inflate_t *inf, const ezld_huffman_t *hf) {
+    int code = 0, first = 0, index = 0;
+
+    // Codes are stored starting from their most significant bit
+    for (size_t len = 1; len < 16; len++) {
+        uint32_t bit;
+        if (!inf_bits(inf, 1, &bit)) {
+            return -1;
+        }
+
+        code |= bit;
+        int count = hf->hf_count[len];
+
+        if (code - count < first) {
+            return hf->hf_symbol[index + (code - first)];
+        }
+
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+/**
+ * @brief Builds a canonical Huffman code from the code length of each symbol
+ *
+ * @return `false` if the lengths describe too many codes
+ */
+static bool inf_build(ezld_huffman_t *hf, const uint8_t *lens, size_t n) {
+    uint16_t offs[16];
+    int      left = 1;
+
+    memset(hf->hf_count, 0, sizeof hf->hf_count);
+    for (size_t i = 0; i < n; i++) {
+        hf->hf_count[lens[i]]++;
+    }
+
+    for (size_t len = 1; len < 16; len++) {
+        left = (left << 1) - hf->hf_count[len];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    offs[1] = 0;
+    for (size_t len = 1; len < 15; len++) {
+        offs[len + 1] = offs[len] + hf->hf_count[len];
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (lens[i] != 0) {
+            hf->hf_symbol[offs[lens[i]]++] = i;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decodes the compressed data of a block up to its end-of-block code
+ */
+static bool inf_codes(ezld_inflate_t       *inf,
+                      const ezld_huffman_t *lencode,
+                      const ezld_huffman_t *distcode) {
+    for (;;) {
+        int sym = inf_decode(inf, lencode);
+
+        if (sym < 0 || sym > 285) {
+            return false;
+        }
+
+        if (sym < 256) {
+            if (inf->inf_outpos >= inf->inf_outlen) {
+                return false;
+            }
+
+            inf->inf_out[inf->inf_outpos++] = sym;
+            continue;
+        }
+
+        if (sym == 256) {
+            return true;
+        }
+
+        uint32_t extra;
+        sym -= 257;
+        if (!inf_bits(inf, g_deflate_len_extra[sym], &extra)) {
+            return false;
+        }
+        size_t len = g_deflate_len_base[sym] + extra;
+
+        sym = inf_decode(inf, distcode);
+        if (sym < 0 || sym > 29 ||
+            !inf_bits(inf, g_deflate_dist_extra[sym], &extra)) {
+            return false;
+        }
+        size_t dist = g_deflate_dist_base[sym] + extra;
+
+        if (dist > inf->inf_outpos || len > inf->inf_outlen - inf->inf_outpos) {
+            return false;
+        }
+
+        // Copies may overlap their source, which repeats it
+        uint8_t       *to   = &inf->inf_out[inf->inf_outpos];
+        const uint8_t *from = to - dist;
+        for (size_t i = 0; i < len; i++) {
+            to[i] = from[i];
+        }
+        inf->inf_outpos += len;
+    }
+}
+
+/**
+ * @brief Copies the contents of a stored (uncompressed) block
+ */
+static bool inf_stored(ezld_inflate_t *inf) {
+    // Stored blocks start on a byte boundary
+    inf->inf_bitbuf = 0;
+    inf->inf_bitcnt = 0;
+
+    if (inf->inf_inlen - inf->inf_inpos < 4) {
+        return false;
+    }
+
+    const uint8_t *hdr = &inf->inf_in[inf->inf_inpos];
+    size_t         len = hdr[0] | (hdr[1] << 8);
+    inf->inf_inpos += 4;
+
+    if (len != (~(hdr[2] | (hdr[3] << 8)) & 0xFFFF) ||
+        len > inf->inf_inlen - inf->inf_inpos ||
+        len > inf->inf_outlen - inf->inf_outpos) {
+        return false;
+    }
+
+    memcpy(&inf->inf_out[inf->inf_outpos], &inf->inf_in[inf->inf_inpos], len);
+    inf->inf_inpos += len;
+    inf->inf_outpos += len;
+    return true;
+}
+
+/**
+ * @brief Decodes a block compressed with the fixed Huffman codes
+ */
+static bool inf_fixed(ezld_inflate_t *inf) {
+    uint8_t        lens[EZLD_DEFLATE_MAX_CODES];
+    ezld_huffman_t lencode, distcode;
+
+    memset(&lens[0], 8, 144);
+    memset(&lens[144], 9, 112);
+    memset(&lens[256], 7, 24);
+    memset(&lens[280], 8, 8);
+    (void)inf_build(&lencode, lens, 288);
+
+    memset(lens, 5, 30);
+    (void)inf_build(&distcode, lens, 30);
+
+    return inf_codes(inf, &lencode, &distcode);
+}
+
+/**
+ * @brief Decodes a block compressed with Huffman codes described at its start
+ */
+static bool inf_dynamic(ezld_inflate_t *inf) {
+    static const uint8_t order[19] = {
+        16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+    uint8_t        lens[EZLD_DEFLATE_MAX_CODES + 32] = {0};
+    ezld_huffman_t lencode, distcode;
+    uint32_t       nlen, ndist, ncode;
+
+    if (!inf_bits(inf, 5, &nlen) || !inf_bits(inf, 5, &ndist) ||
+        !inf_bits(inf, 4, &ncode)) {
+        return false;
+    }
+
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+
+    if (nlen > 286 || ndist > 30) {
+        return false;
+    }
+
+    // The code lengths are themselves Huffman-coded
+    for (size_t i = 0; i < ncode; i++) {
+        uint32_t len;
+        if (!inf_bits(inf, 3, &len)) {
+            return false;
+        }
+        lens[order[i]] = len;
+    }
+
+    if (!inf_build(&lencode, lens, 19)) {
+        return false;
+    }
+
+    memset(lens, 0, sizeof lens);
+    for (size_t i = 0; i < nlen + ndist;) {
+        int      sym = inf_decode(inf, &lencode);
+        uint32_t rep;
+        uint8_t  len = 0;
+
+        if (sym < 0) {
+            return false;
+        }
+
+        if (sym < 16) {
+            lens[i++] = sym;
+            continue;
+        }
+
+        if (sym == 16) {
+            if (i == 0 || !inf_bits(inf, 2, &rep)) {
+                return false;
+            }
+            len = lens[i - 1];
+            rep += 3;
+        } else if (sym == 17) {
+            if (!inf_bits(inf, 3, &rep)) {
+                return false;
+            }
+            rep += 3;
+        } else {
+            if (!inf_bits(inf, 7, &rep)) {
+                return false;
+            }
+            rep += 11;
+        }
+
+        if (i + rep > nlen + ndist) {
+            return false;
+        }
+
+        for (; rep > 0; rep--) {
+            lens[i++] = len;
+        }
+    }
+
+    if (lens[256] == 0 || !inf_build(&lencode, lens, nlen) ||
+        !inf_build(&distcode, &lens[nlen], ndist)) {
+        return false;
+    }
+
+    return inf_codes(inf, &lencode, &distcode);
+}
+
+/**
+ * @brief Decompresses a zlib stream whose decompressed size is known
+ *
+ * @param out where to store the decompressed data
+ * @param outlen the size of the decompressed data
+ * @param in the zlib stream
+ * @param inlen the size of the zlib stream
+ *
+ * @return `true` if the stream is valid and has exactly the expected size
+ */
+bool ezld_inflate_zlib(uint8_t       *out,
+                       size_t         outlen,
+                       const uint8_t *in,
+                       size_t         inlen) {
+    ezld_inflate_t inf = {.inf_in     = in,
+                          .inf_inlen  = inlen,
+                          .inf_inpos  = 2,
+                          .inf_out    = out,
+                          .inf_outlen = outlen};
+
+    // Deflate compression, no preset dictionary
+    if (inlen < 6 || (in[0] & 0x0F) != 8 || (in[1] & 0x20) ||
+        ((in[0] << 8) | in[1]) % 31 != 0) {
+        return false;
+    }
+
+    uint32_t last = 0;
+    while (!last) {
+        uint32_t type;
+        bool     ok;
+
+        if (!inf_bits(&inf, 1, &last) || !inf_bits(&inf, 2, &type)) {
+            return false;
+        }
+
+        switch (type) {
+        case 0:
+            ok = inf_stored(&inf);
+            break;
+        case 1:
+            ok = inf_fixed(&inf);
+            break;
+        case 2:
+            ok = inf_dynamic(&inf);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+
+        if (!ok) {
+            return false;
+        }
+    }
+
+    // The checksum follows on the next byte boundary
+    if (inf.inf_outpos != outlen || inf.inf_inlen - inf.inf_inpos < 4) {
+        return false;
+    }
+
+    const uint8_t *sum = &in[inf.inf_inpos];
+    return adler32(out, outlen) == (((uint32_t)sum[0] << 24) | (sum[1] << 16) |
+                                    (sum[2] << 8) | sum[3]);
+}
+
+/**
+ * @param len the size of the data to compress
+ *
+ * @return the maximum size of the zlib stream holding `len` bytes, which takes
+ * at most 9 bits for each of them
+ */
+size_t ezld_deflate_bound(size_t len) {
+    return len + len / 8 + 16;
+}
+
+/**
+ * @brief Appends bits to a deflate stream
+ *
+ * @param def the compression state
+ * @param bits the bits, the first one being the least significant
+ * @param n the number of bits, at most 16
+ */
+static void def_bits(ezld_deflate_t *def, uint32_t bits, unsigned n) {
+    def->def_bitbuf |= bits << def->def_bitcnt;
+    def->def_bitcnt += n;
+
+    while (def->def_bitcnt >= 8) {
+        def->def_out[def->def_outpos++] = def->def_bitbuf & 0xFF;
+        def->def_bitbuf >>= 8;
+        def->def_bitcnt -= 8;
+    }
+}
+
+/**
+ * @brief Appends a Huffman code to a deflate stream. Unlike other fields, codes
+ * are stored starting from their most significant bit
+ */
+static void def_code(ezld_deflate_t *def, uint32_t code, unsigned len) {
+    uint32_t rev = 0;
+
+    for (unsigned i = 0; i < len; i++) {
+        rev = (rev << 1) | ((code >> i) & 1);
+    }
+
+    def_bits(def, rev, len);
+}
+
+/**
+ * @brief Appends a literal/length symbol with its fixed Huffman code
+ */
+static void def_symbol(ezld_deflate_t *def, unsigned sym) {
+    if (sym < 144) {
+        def_code(def, 0x30 + sym, 8);
+    } else if (sym < 256) {
+        def_code(def, 0x190 + (sym - 144), 9);
+    } else if (sym < 280) {
+        def_code(def, sym - 256, 7);
+    } else {
+        def_code(def, 0xC0 + (sym - 280), 8);
+    }
+}
+
+/**
+ * @brief Appends a match with the fixed Huffman codes
+ *
+ * @param def the compression state
+ * @param len the length of the match
+ * @param dist the distance of the match
+ */
+static void def_match(ezld_deflate_t *def, size_t len, size_t dist) {
+    size_t lc = 28, dc = 29;
+
+    while (g_deflate_len_base[lc] > len) {
+        lc--;
+    }
+
+    while (g_deflate_dist_base[dc] > dist) {
+        dc--;
+    }
+
+    def_symbol(def, 257 + lc);
+    def_bits(def, len - g_deflate_len_base[lc], g_deflate_len_extra[lc]);
+    def_code(def, dc, 5);
+    def_bits(def, dist - g_deflate_dist_base[dc], g_deflate_dist_extra[dc]);
+}
+
+/**
+ * @param p the data
+ *
+ * @return the hash of the first 3 bytes of `p`
+ */
+static size_t deflate_hash(const uint8_t *p) {
+    uint32_t seq = (p[0] << 16) | (p[1] << 8) | p[2];
+    return (seq * 2654435761U) >> (32 - EZLD_DEFLATE_HASH_BITS);
+}
+
+/**
+ * @brief Compresses data to a zlib stream made of a single block that uses the
+ * fixed Huffman codes. Matches are found with a greedy parser that follows
+ * chains of earlier positions with the same 3-byte hash
+ *
+ * @param dst the destination buffer, at least `ezld_deflate_bound(len)` bytes
+ * long
+ * @param src the data to compress
+ * @param len the size of the data
+ * @param tabs the tables to find matches with, whose contents do not matter
+ *
+ * @return the size of the zlib stream
+ */
+size_t ezld_deflate_zlib(uint8_t             *dst,
+                        const uint8_t       *src,
+                        size_t               len,
+                        ezld_deflate_tabs_t *tabs) {
+    size_t *head = tabs->dt_head;
+    size_t *prev = tabs->dt_prev;
+    memset(tabs, 0, sizeof(ezld_deflate_tabs_t));
+
+    // Deflate with a 32 KiB window, default level
+    ezld_deflate_t def = {.def_out = dst, .def_outpos = 2};
+    dst[0]             = 0x78;
+    dst[1]             = 0x9C;
+
+    // Final block, fixed Huffman codes
+    def_bits(&def, 1, 1);
+    def_bits(&def, 1, 2);
+
+    size_t ip = 0;
+    while (ip < len) {
+        size_t best = 0, dist = 0;
+
+        if (ip + EZLD_DEFLATE_MIN_MATCH <= len) {
+            size_t h     = deflate_hash(&src[ip]);
+            size_t chain = head[h];
+            size_t max   = len - ip;
+
+            if (max > EZLD_DEFLATE_MAX_MATCH) {
+                max = EZLD_DEFLATE_MAX_MATCH;
+            }
+
+            for (size_t n = 0; chain != 0 && n < EZLD_DEFLATE_MAX_CHAIN; n++) {
+                size_t cand = chain - 1;
+                if (ip - cand > EZLD_DEFLATE_WINDOW) {
+                    break;
+                }
+
+                size_t mlen = 0;
+                while (mlen < max && src[cand + mlen] == src[ip + mlen]) {
+                    mlen++;
+                }
+
+                if (mlen > best) {
+                    best = mlen;
+                    dist = ip - cand;
+                }
+
+                if (best == max) {
+                    break;
+                }
+
+                chain = prev[cand % EZLD_DEFLATE_WINDOW];
+            }
+        }
+
+        if (best < EZLD_DEFLATE_MIN_MATCH) {
+            def_symbol(&def, src[ip]);
+            best = 1;
+        } else {
+            def_match(&def, best, dist);
+        }
+
+        // Every position covered is added to the chains
+        for (size_t end = ip + best; ip < end; ip++) {
+            if (ip + EZLD_DEFLATE_MIN_MATCH <= len) {
+                size_t h                         = deflate_hash(&src[ip]);
+                prev[ip % EZLD_DEFLATE_WINDOW] = head[h];
+                head[h]                          = ip + 1;
+            }
+        }
+    }
+
+    // End of block, then the checksum on the next byte boundary
+    def_symbol(&def, 256);
+    def_bits(&def, 0, 7);
+
+    uint32_t sum           = adler32(src, len);
+    dst[def.def_outpos++] = sum >> 24;
+    dst[def.def_outpos++] = sum >> 16;
+    dst[def.def_outpos++] = sum >> 8;
+    dst[def.def_outpos++] = sum;
+
+    return def.def_outpos;
+}
@@ -0,0 +1,272 @@
+// MIT License
+//
+// Copyright (c) 2025 - 2026 Alessandro Salerno
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <ezld/hash.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * @brief Fills the lookup tables of a slice-by-16 CRC32 kernel. `tables[0]` is
+ * the usual byte-wise table, and `tables[k]` gives the contribution of a byte
+ * followed by `k` more bytes
+ *
+ * @param tables the tables to fill
+ * @param poly the bit-reversed generator polynomial
+ */
+void ezld_hash_crc32_tables(uint32_t tables[16][256], uint32_t poly) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+
+        for (size_t b = 0; b < 8; b++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+        }
+
+        tables[0][i] = crc;
+    }
+
+    for (size_t k = 1; k < 16; k++) {
+        for (size_t i = 0; i < 256; i++) {
+            uint32_t prev = tables[k - 1][i];
+            tables[k][i]  = (prev >> 8) ^ tables[0][prev & 0xFF];
+        }
+    }
+}
+
+/**
+ * @brief Updates a CRC32 with more data, 16 bytes at a time
+ *
+ * @param tables the tables filled by `ezld_hash_crc32_tables`
+ * @param crc the current (pre-inverted) CRC
+ * @param data the data
+ * @param len the size of the data
+ *
+ * @return the updated CRC
+ */
+uint32_t ezld_hash_crc32_update(uint32_t       tables[16][256],
+                                uint32_t       crc,
+                                const uint8_t *data,
+                                size_t         len) {
+    for (; len >= 16; data += 16, len -= 16) {
+        uint32_t w = crc ^ (data[0] | (data[1] << 8) | (data[2] << 16) |
+                            ((uint32_t)data[3] << 24));
+
+        crc = tables[15][w & 0xFF] ^ tables[14][(w >> 8) & 0xFF];
+        crc ^= tables[13][(w >> 16) & 0xFF] ^ tables[12][w >> 24];
+
+        for (size_t i = 4; i < 16; i++) {
+            crc ^= tables[15 - i][data[i]];
+        }
+    }
+
+    for (; len != 0; data++, len--) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *data) & 0xFF];
+    }
+
+    return crc;
+}
+
+static inline uint32_t rotl32(uint32_t val, unsigned bits) {
+    return (val << bits) | (val >> (32 - bits));
+}
+
+static inline uint64_t rotl64(uint64_t val, unsigned bits) {
+    return (val << bits) | (val >> (64 - bits));
+}
+
+static inline uint64_t read_le64(const uint8_t *p) {
+    uint64_t val = 0;
+
+    for (size_t i = 0; i < 8; i++) {
+        val |= (uint64_t)p[i] << (8 * i);
+    }
+
+    return val;
+}
+
+static inline uint32_t read_le32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#define EZLD_XXH64_PRIME1 0x9E3779B185EBCA87ULL
+#define EZLD_XXH64_PRIME2 0xC2B2AE3D27D4EB4FULL
+#define EZLD_XXH64_PRIME3 0x165667B19E3779F9ULL
+#define EZLD_XXH64_PRIME4 0x85EBCA77C2B2AE63ULL
+#define EZLD_XXH64_PRIME5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t xxh64_round(uint64_t acc, uint64_t input) {
+    acc += input * EZLD_XXH64_PRIME2;
+    return rotl64(acc, 31) * EZLD_XXH64_PRIME1;
+}
+
+static inline uint64_t xxh64_merge(uint64_t acc, uint64_t val) {
+    acc ^= xxh64_round(0, val);
+    return acc * EZLD_XXH64_PRIME1 + EZLD_XXH64_PRIME4;
+}
+
+/**
+ * @brief Computes the XXH64 hash of a buffer
+ *
+ * @param data the buffer
+ * @param len the length of the buffer
+ * @param seed the seed of the hash
+ *
+ * @return the hash
+ */
+uint64_t ezld_hash_xxh64(const uint8_t *data, size_t len, uint64_t seed) {
+    const uint8_t *end = data + len;
+    uint64_t       h;
+
+    if (len >= 32) {
+        uint64_t v1 = seed + EZLD_XXH64_PRIME1 + EZLD_XXH64_PRIME2;
+        uint64_t v2 = seed + EZLD_XXH64_PRIME2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - EZLD_XXH64_PRIME1;
+
+        for (; end - data >= 32; data += 32) {
+            v1 = xxh64_round(v1, read_le64(data));
+            v2 = xxh64_round(v2, read_le64(data + 8));
+            v3 = xxh64_round(v3, read_le64(data + 16));
+            v4 = xxh64_round(v4, read_le64(data + 24));
+        }
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxh64_merge(h, v1);
+        h = xxh64_merge(h, v2);
+        h = xxh64_merge(h, v3);
+        h = xxh64_merge(h, v4);
+    } else {
+        h = seed + EZLD_XXH64_PRIME5;
+    }
+
+    h += len;
+
+    for (; end - data >= 8; data += 8) {
+        h ^= xxh64_round(0, read_le64(data));
+        h = rotl64(h, 27) * EZLD_XXH64_PRIME1 + EZLD_XXH64_PRIME4;
+    }
+
+    if (end - data >= 4) {
+        h ^= read_le32(data) * EZLD_XXH64_PRIME1;
+        h = rotl64(h, 23) * EZLD_XXH64_PRIME2 + EZLD_XXH64_PRIME3;
+        data += 4;
+    }
+
+    for (; data < end; data++) {
+        h ^= *data * EZLD_XXH64_PRIME5;
+        h = rotl64(h, 11) * EZLD_XXH64_PRIME1;
+    }
+
+    h ^= h >> 33;
+    h *= EZLD_XXH64_PRIME2;
+    h ^= h >> 29;
+    h *= EZLD_XXH64_PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+static void sha1_block(uint32_t state[5], const uint8_t *block) {
+    uint32_t w[80];
+
+    for (size_t i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)block[4 * i] << 24) | (block[4 * i + 1] << 16) |
+               (block[4 * i + 2] << 8) | block[4 * i + 3];
+    }
+
+    for (size_t i = 16; i < 80; i++) {
+        w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3],
+             e = state[4];
+
+    for (size_t i = 0; i < 80; i++) {
+        uint32_t f, k;
+
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+
+        uint32_t tmp = rotl32(a, 5) + f + e + k + w[i];
+        e            = d;
+        d            = c;
+        c            = rotl32(b, 30);
+        b            = a;
+        a            = tmp;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+/**
+ * @brief Computes the SHA-1 digest of a buffer
+ *
+ * @param data the buffer
+ * @param len the length of the buffer
+ * @param digest where to store the 20-byte digest
+ */
+void ezld_hash_sha1(const uint8_t *data, size_t len, uint8_t *digest) {
+    uint32_t state[5] = {
+        0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    uint8_t  tail[128] = {0};
+    uint64_t bits      = (uint64_t)len * 8;
+    size_t   full      = len - len % 64;
+
+    for (size_t i = 0; i < full; i += 64) {
+        sha1_block(state, &data[i]);
+    }
+
+    // The rest of the data is followed by a one bit, zeros, and the length
+    // in bits, which take one or two more blocks
+    size_t rest = len - full;
+    size_t tlen = (rest < 56) ? 64 : 128;
+    memcpy(tail, &data[full], rest);
+    tail[rest] = 0x80;
+
+    for (size_t i = 0; i < 8; i++) {
+        tail[tlen - 1 - i] = bits >> (8 * i);
+    }
+
+    for (size_t i = 0; i < tlen; i += 64) {
+        sha1_block(state, &tail[i]);
+    }
+
+    for (size_t i = 0; i < 5; i++) {
+        digest[4 * i]     = state[i] >> 24;
+        digest[4 * i + 1] = state[i] >> 16;
+        digest[4 * i + 2] = state[i] >> 8;
+        digest[4 * i + 3] = state[i];
+    }
+}
@@ -0,0 +1,126 @@
+// MIT License
+//
+// Copyright (c) 2025 - 2026 Alessandro Salerno
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <ezld/htab.h>
+#include <ezld/runtime.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static ezld_htab_ent_t *
+find_slot(ezld_htab_t *htab, const void *key, size_t keylen, size_t hash) {
+    size_t mask = htab->ht_cap - 1;
+
+    for (size_t i = hash & mask;; i = (i + 1) & mask) {
+        ezld_htab_ent_t *ent = &htab->ht_buf[i];
+
+        if (ent->he_key == NULL) {
+            return ent;
+        }
+
+        if (ent->he_hash == hash && ent->he_keylen == keylen &&
+            memcmp(ent->he_key, key, keylen) == 0) {
+            return ent;
+        }
+    }
+}
+
+static void grow(ezld_htab_t *htab) {
+    ezld_htab_ent_t *old_buf = htab->ht_buf;
+    size_t           old_cap = htab->ht_cap;
+
+    htab->ht_cap = (old_cap == 0) ? 64 : old_cap * 2;
+    htab->ht_buf = ezld_runtime_alloc(sizeof(ezld_htab_ent_t), htab->ht_cap);
+    memset(htab->ht_buf, 0, sizeof(ezld_htab_ent_t) * htab->ht_cap);
+
+    for (size_t i = 0; i < old_cap; i++) {
+        ezld_htab_ent_t *ent = &old_buf[i];
+
+        if (ent->he_key != NULL) {
+            *find_slot(htab, ent->he_key, ent->he_keylen, ent->he_hash) = *ent;
+        }
+    }
+
+    free(old_buf);
+}
+
+size_t ezld_htab_hash(const void *key, size_t keylen) {
+    // 64-bit FNV-1a, truncated on 32-bit hosts
+    const uint8_t *bytes = key;
+    uint64_t       hash  = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < keylen; i++) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+bool ezld_htab_get(ezld_htab_t *htab,
+                   const void  *key,
+                   size_t       keylen,
+                   size_t      *value) {
+    if (htab->ht_len == 0) {
+        return false;
+    }
+
+    size_t           hash = ezld_htab_hash(key, keylen);
+    ezld_htab_ent_t *ent  = find_slot(htab, key, keylen, hash);
+
+    if (ent->he_key == NULL) {
+        return false;
+    }
+
+    *value = ent->he_value;
+    return true;
+}
+
+bool ezld_htab_put(ezld_htab_t *htab,
+                   const void  *key,
+                   size_t       keylen,
+                   size_t      *value) {
+    // Keep the load factor under 3/4 so that probing always terminates
+    if ((htab->ht_len + 1) * 4 > htab->ht_cap * 3) {
+        grow(htab);
+    }
+
+    size_t           hash = ezld_htab_hash(key, keylen);
+    ezld_htab_ent_t *ent  = find_slot(htab, key, keylen, hash);
+
+    if (ent->he_key != NULL) {
+        *value = ent->he_value;
+        return true;
+    }
+
+    ent->he_key    = key;
+    ent->he_keylen = keylen;
+    ent->he_hash   = hash;
+    ent->he_value  = *value;
+    htab->ht_len++;
+    return false;
+}
+
+void ezld_htab_free(ezld_htab_t *htab) {
+    free(htab->ht_buf);
+    ezld_htab_init(*htab);
+}
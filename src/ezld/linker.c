@@ -21,18 +21,89 @@
 // SOFTWARE.
 
 #include <assert.h>
+#include <ezld/deflate.h>
+#include <ezld/hash.h>
+#include <ezld/htab.h>
 #include <ezld/linker.h>
+#include <ezld/lz4.h>
 #include <ezld/runtime.h>
 #include <musl/elf.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #define EZLD_ENTRY_NAME         0
 #define EZLD_GLOB_SYM_UNDEF     0
 #define EZLD_ELF_OUT_FLAG_UNSET 0
+#define EZLD_ORDER_NONE         SIZE_MAX
+#define EZLD_CG_NONE            SIZE_MAX
+
+// Ranks of the runs in which input sections are grouped inside their merged
+// section, in layout order
+#define EZLD_RANK_HOT      0
+#define EZLD_RANK_DEFAULT  1
+#define EZLD_RANK_STARTUP  2
+#define EZLD_RANK_UNLIKELY 3
+
+// Flags that describe how an input section was produced rather than how its
+// contents are to be loaded, and that may thus differ among the sections
+// folded into the same merged section
+#define EZLD_SHF_INPUT_ONLY (SHF_MERGE | SHF_STRINGS | SHF_GROUP)
+
+// Reach of R_RISCV_JAL and R_RISCV_BRANCH, as [-reach, reach)
+#define EZLD_JAL_REACH    (1 << 20)
+#define EZLD_BRANCH_REACH (1 << 12)
+// Size of a range-extension thunk (auipc t1 + jalr x0, t1)
+#define EZLD_THUNK_SIZE 8
+// Layout passes after which thunks are no longer added, so that pathological
+// inputs can not make the linker loop forever
+#define EZLD_THUNK_MAX_PASSES 16
+
+// Data bytes per record in Intel HEX and S-record output
+#define EZLD_HEX_RECORD_LEN 16
+// Intel HEX record types
+#define EZLD_IHEX_DATA              0x00
+#define EZLD_IHEX_EOF               0x01
+#define EZLD_IHEX_EXT_LINEAR_ADDR   0x04
+#define EZLD_IHEX_START_LINEAR_ADDR 0x05
+
+// Size of an entry of the table read by the unpacking stub
+#define EZLD_UNPACK_ENT_SIZE 16
+
+// Build IDs computed from the output are hashed in blocks of this size, whose
+// digests are then hashed together
+#define EZLD_BUILD_ID_BLOCK (1024 * 1024)
+#define EZLD_BUILD_ID_BATCH 8
+// Sizes of the build ID for each `EZLD_BUILD_ID_*` kind
+#define EZLD_BUILD_ID_FAST_SIZE 8
+#define EZLD_BUILD_ID_SHA1_SIZE 20
+#define EZLD_BUILD_ID_UUID_SIZE 16
+
+// Debugging sections are written in chunks of this size. Chunks never end less
+// than this many bytes after the start of a relocated field, which leaves room
+// for the longest ULEB128 value
+#define EZLD_DEBUG_CHUNK     (64 * 1024)
+#define EZLD_DEBUG_FIELD_MAX 16
+
+// Number of entries of the dynamic section of static PIEs (DT_RELR,
+// DT_RELRSZ, DT_RELRENT, DT_FLAGS_1, and DT_NULL)
+#define EZLD_DYNAMIC_ENTRIES 5
+
+// Bits of Bloom filter per symbol in the symbol hash section, and shift used
+// to derive the second bit from the hash
+#define EZLD_SYMHASH_BLOOM_BITS  12
+#define EZLD_SYMHASH_BLOOM_SHIFT 26
+
+// Clusters are not grown past this size, since the point of merging them is to
+// keep callers and callees on the same pages
+#define EZLD_CG_CLUSTER_LIMIT (1024 * 1024)
+// A merge is rejected if it would make the density of the caller's cluster
+// drop by more than this factor
+#define EZLD_CG_MAX_DENSITY_DROP 8
 
 #define EZLD_MAYBE_FUTURE __attribute__((used))
 
@@ -40,6 +111,34 @@
 
 typedef struct ezld_mrg_sec ezld_mrg_sec_t;
 typedef struct ezld_obj     ezld_obj_t;
+typedef struct ezld_obj_sec ezld_obj_sec_t;
+
+/**
+ * @brief A piece of an SHF_MERGE section
+ *
+ * Mergeable sections are split into pieces (fixed-size entries or
+ * null-terminated strings) that are deduplicated across all object files
+ */
+typedef struct ezld_sec_piece {
+    /** Offset of this piece in the object file section */
+    size_t sp_inoff;
+    /** Offset of the (possibly shared) copy of this piece in the synthetic
+     * section holding the deduplicated contents */
+    size_t sp_outoff;
+} ezld_sec_piece_t;
+
+/**
+ * @brief A relocation whose value was computed in advance, so that it can be
+ * applied when the contents of its section are written
+ */
+typedef struct ezld_data_reloc {
+    /** Offset of the relocated field in the section */
+    uint32_t dr_off;
+    /** Relocation type, one of those supported by `apply_data_relocs` */
+    uint32_t dr_type;
+    /** Value of the symbol plus the addend of the relocation (S + A) */
+    uint32_t dr_value;
+} ezld_data_reloc_t;
 
 /**
  * @brief An object file section
@@ -47,7 +146,7 @@ typedef struct ezld_obj     ezld_obj_t;
  * This type represent a section in an ELF object file and is used for in-memory
  * linking
  */
-typedef struct ezld_obj_sec {
+struct ezld_obj_sec {
     /** Pointer to the object file struct to which this section belongs */
     ezld_obj_t *os_obj;
     /** Copy of the ELF section header of this section */
@@ -71,7 +170,38 @@ typedef struct ezld_obj_sec {
     /** Index into the global section header string table where the name of this
      * object section lies */
     size_t os_name;
-} ezld_obj_sec_t;
+    /** Synthetic section holding the deduplicated contents of this section if
+     * it has the SHF_MERGE flag, `NULL` otherwise. When set, this section is
+     * not part of `os_mrg.ms_oss` and offsets into it must be translated with
+     * `translate_off` */
+    ezld_obj_sec_t *os_mrgsyn;
+    /** Pieces in which this section was split if `os_mrgsyn` is set, sorted by
+     * input offset */
+    ezld_array(ezld_sec_piece_t) os_pieces;
+    /** `true` if this section is a member of a COMDAT group whose signature
+     * was already seen in another object file. Discarded sections are never
+     * read, merged, or relocated */
+    bool os_discarded;
+    /** Sort key used by `layout_sections` to place this section inside its
+     * merged section. Sections with lower keys come first, ties are broken by
+     * input order. `EZLD_ORDER_NONE` if no specific order was requested */
+    size_t os_order;
+    /** One of the `EZLD_RANK_*` values, taken from the name of this section.
+     * Sections are grouped by rank before `os_order` is considered */
+    size_t os_rank;
+    /** Synthetic section holding range-extension thunks that is placed right
+     * after this section, or `NULL` */
+    ezld_obj_sec_t *os_island;
+    /** Size of the zlib stream found at `os_shdr.sh_offset` if this section
+     * was compressed (SHF_COMPRESSED) in the object file, 0 otherwise. The
+     * section header describes the uncompressed contents, which are inflated
+     * by `read_section_contents` */
+    size_t os_zsize;
+    /** Relocations of this section that are applied while its contents are
+     * written, rather than to its contents in memory. Set by
+     * `apply_relocations` for debugging sections */
+    ezld_array(ezld_data_reloc_t) os_drelocs;
+};
 
 /**
  * @brief An in-memory representation of a section obtained by merging sections
@@ -85,17 +215,65 @@ typedef struct ezld_mrg_sec {
     size_t ms_ndx;
     /** Virtual address associated with this merged section */
     size_t ms_vaddr;
+    /** Virtual address requested for this merged section by the
+     * configuration, or 0 if it is to be placed after the previous one */
+    size_t ms_reqvaddr;
+    /** Load address associated with this merged section, which is the same as
+     * `ms_vaddr` unless its segment is loaded elsewhere */
+    size_t ms_paddr;
+    /** Load address requested for this merged section by the configuration,
+     * or 0 if it is loaded at its virtual address */
+    size_t ms_reqpaddr;
     /** Memory size of this merged section */
     size_t ms_memsz;
     /** Offset into the final executable file where the segment relative to this
      * merged section is found. This field is 0 upon allocation, and is set in
-     * `write_exec` for use by that function and by relocation functions */
+     * `write_exec` */
     size_t ms_fileoff;
+    /** Template for the section header of this merged section: type and flags
+     * shared by all its object file sections, and the largest alignment among
+     * them (set by `layout_sections`) */
+    Elf32_Shdr ms_shdr;
     /** Array of object file sections from which this merged section was
      * obtained */
     ezld_array(ezld_obj_sec_t *) ms_oss;
+    /** Index of the section header of this merged section in the output file,
+     * or 0 if it is not written. Set by `number_sections` */
+    size_t ms_outndx;
+    /** Index of the STT_SECTION symbol of this merged section in the output
+     * symbol table. Set by `build_symtab` */
+    size_t ms_symndx;
+    /** Relocations to be written for this merged section. Set by
+     * `collect_relocs` */
+    ezld_array(Elf32_Rela) ms_relas;
+    /** Compressed contents of this merged section, starting with their
+     * Elf32_Chdr, or `NULL` if it is written uncompressed. Set by
+     * `compress_debug_sections` */
+    uint8_t *ms_zdata;
+    /** Size of `ms_zdata` */
+    size_t ms_zsize;
 } ezld_mrg_sec_t;
 
+/**
+ * @brief A loadable segment of the output, made of merged sections with the
+ * same permissions laid out next to each other
+ */
+typedef struct ezld_out_seg {
+    /** Virtual address of the segment (that of its first merged section) */
+    size_t sg_vaddr;
+    /** Load address of the segment (that of its first merged section) */
+    size_t sg_paddr;
+    /** Memory size of the segment, including padding between sections */
+    size_t sg_memsz;
+    /** Size of the part of the segment backed by the file. This is smaller
+     * than `sg_memsz` if the segment ends with SHT_NOBITS sections */
+    size_t sg_filesz;
+    /** PF_* flags of the segment */
+    uint32_t sg_flags;
+    /** Merged sections in this segment, in address order */
+    ezld_array(ezld_mrg_sec_t *) sg_mss;
+} ezld_out_seg_t;
+
 /**
  * @brief A symbol contained in an object file symbol table
  */
@@ -109,6 +287,10 @@ typedef struct ezld_obj_sym_t {
     /** Name of this symbol obtained from the object file symbol table using
      * `osy_esym.st_name` */
     const char *osy_name;
+    /** Index of this symbol (or of the global symbol it resolves to) in the
+     * output symbol table, or 0 if it is not part of it. Set by
+     * `build_symtab` */
+    size_t osy_outndx;
 } ezld_obj_sym_t;
 
 /**
@@ -163,6 +345,183 @@ typedef struct ezld_glob_strtab {
     ezld_array(ezld_glob_str_t) gst_strs;
 } ezld_glob_strtab_t;
 
+/**
+ * @brief A symbol in the global symbol table
+ */
+typedef struct ezld_glob_sym {
+    /** Symbol table entry. `st_shndx` is the index of the merged section in
+     * which the symbol is defined. `st_value` is relative to `gsy_os` until
+     * `virtualize_syms` turns it into a virtual address */
+    Elf32_Sym gsy_esym;
+    /** Object file section in which the symbol is defined */
+    ezld_obj_sec_t *gsy_os;
+    /** Offset of the symbol in `gsy_os`, kept so that `virtualize_syms` can
+     * run again if the layout changes */
+    size_t gsy_off;
+} ezld_glob_sym_t;
+
+/**
+ * @brief A symbol table built for the output file
+ */
+typedef struct ezld_out_symtab {
+    /** Symbol table entries, starting with the null symbol */
+    ezld_array(Elf32_Sym) ot_syms;
+    /** Contents of the associated string table */
+    ezld_array(char) ot_strs;
+    /** Index of the first non-local symbol, as required for `sh_info` */
+    size_t ot_firstglob;
+} ezld_out_symtab_t;
+
+/**
+ * @brief An entry of an output symbol table being sorted
+ */
+typedef struct ezld_sort_sym {
+    /** The symbol table entry */
+    Elf32_Sym ss_sym;
+    /** Index of the entry before sorting */
+    size_t ss_old;
+} ezld_sort_sym_t;
+
+/**
+ * @brief A symbol being placed in the symbol hash section
+ */
+typedef struct ezld_symhash_ent {
+    /** GNU hash of the name of the symbol */
+    uint32_t she_hash;
+    /** Bucket of the symbol */
+    size_t she_bucket;
+    /** Index of the symbol in `g_self.i_globsymtab` */
+    size_t she_ndx;
+} ezld_symhash_ent_t;
+
+/**
+ * @brief The place of a relocation that must be applied again at run time
+ * because it stores an absolute address
+ */
+typedef struct ezld_reloc_site {
+    /** Object file section holding the place */
+    ezld_obj_sec_t *rs_os;
+    /** Offset of the place in `rs_os` */
+    size_t rs_off;
+} ezld_reloc_site_t;
+
+/**
+ * @brief State shared by the threads hashing the blocks of the output for its
+ * build ID
+ */
+typedef struct ezld_build_hash {
+    /** Up to `EZLD_BUILD_ID_BATCH` blocks of contents waiting to be hashed */
+    uint8_t *bh_data;
+    /** Number of bytes in `bh_data` */
+    size_t bh_len;
+    /** Index of the first block in `bh_data` */
+    size_t bh_first;
+    /** Number of bytes hashed or waiting to be, in all */
+    size_t bh_pos;
+    /** Value of `bh_pos` at the start of the section being hashed */
+    size_t bh_base;
+    /** One of the `EZLD_BUILD_ID_*` values */
+    int bh_kind;
+    /** Size of the digest of each block */
+    size_t bh_digestsz;
+    /** Digests of the blocks, one after the other */
+    uint8_t *bh_digests;
+} ezld_build_hash_t;
+
+/**
+ * @brief A non-allocated section to be compressed by `compress_section`. All
+ * buffers are allocated beforehand, since the compression runs in threads that
+ * must not exit
+ */
+typedef struct ezld_zjob {
+    /** The merged section */
+    ezld_mrg_sec_t *zj_mrg;
+    /** Uncompressed contents of the section, `ms_memsz` bytes long */
+    uint8_t *zj_data;
+    /** Compressed section, with its header, `sizeof(Elf32_Chdr) +
+     * ezld_deflate_bound(ms_memsz)` bytes long */
+    uint8_t *zj_zdata;
+    /** Size of the compressed section, with its header */
+    size_t zj_zsize;
+    /** Tables of the compressor */
+    ezld_deflate_tabs_t *zj_tabs;
+} ezld_zjob_t;
+
+/**
+ * @brief A range-extension thunk, that is a stub jumping to a target that is
+ * too far away to be reached by some `jal ra` instruction
+ */
+typedef struct ezld_thunk {
+    /** Object file containing the first relocation that needed the thunk */
+    ezld_obj_t *th_obj;
+    /** Symbol referenced by that relocation */
+    ezld_obj_sym_t *th_sym;
+    /** Addend of that relocation. The thunk jumps to S + A, which is computed
+     * again after every layout change */
+    int32_t th_addend;
+    /** Address the thunk jumps to with the current layout */
+    uint32_t th_target;
+    /** Thunk island holding the thunk */
+    ezld_obj_sec_t *th_island;
+    /** Offset of the thunk in `th_island` */
+    size_t th_off;
+} ezld_thunk_t;
+
+/**
+ * @brief Deduplication state for the synthetic section obtained by merging
+ * SHF_MERGE sections with the same name, flags, and entry size
+ */
+typedef struct ezld_mrg_syn {
+    /** The synthetic section */
+    ezld_obj_sec_t *msy_os;
+    /** Hash table mapping the contents of a piece to its offset in `msy_data`.
+     * Keys point into the object file sections the pieces come from */
+    ezld_htab_t msy_htab;
+    /** Deduplicated contents */
+    ezld_array(uint8_t) msy_data;
+} ezld_mrg_syn_t;
+
+/**
+ * @brief A node in the call graph used by `sort_call_graph`. Each node is an
+ * executable object file section and, at the same time, the cluster of which it
+ * is the leader
+ */
+typedef struct ezld_cg_node {
+    /** The object file section */
+    ezld_obj_sec_t *cgn_os;
+    /** Index of the leader of the cluster this node belongs to */
+    size_t cgn_leader;
+    /** Index of the next node in the cluster (circular) */
+    size_t cgn_next;
+    /** Index of the previous node in the cluster (circular) */
+    size_t cgn_prev;
+    /** Sum of the weights of all calls into this node */
+    uint64_t cgn_initweight;
+    /** Sum of the weights of all calls into the cluster (if leader) */
+    uint64_t cgn_weight;
+    /** Size in bytes of the cluster (if leader) */
+    size_t cgn_size;
+    /** Index of the node that calls this node the most, or `EZLD_CG_NONE` */
+    size_t cgn_bestpred;
+    /** Weight of the calls from `cgn_bestpred` */
+    uint64_t cgn_bestweight;
+} ezld_cg_node_t;
+
+/**
+ * @brief A weighted edge in the call graph used by `sort_call_graph`
+ */
+typedef struct ezld_cg_edge {
+    /** Index of the calling node */
+    size_t cge_from;
+    /** Index of the called node */
+    size_t cge_to;
+    /** Number of calls (static call sites or profiled calls) */
+    uint64_t cge_weight;
+} ezld_cg_edge_t;
+
+typedef ezld_array(ezld_cg_edge_t) ezld_cg_edges_t;
+typedef ezld_array(Elf32_Shdr) ezld_shdrs_t;
+
 /**
  * @brief A description of the final output of the linker
  */
@@ -183,15 +542,52 @@ typedef struct ezld_output {
 
 typedef struct ezld_instance {
     /** Array of merged sections */
-    ezld_array(ezld_mrg_sec_t) i_mss;
+    ezld_array(ezld_mrg_sec_t *) i_mss;
     /** Array of object files */
     ezld_array(ezld_obj_t) i_objs;
+    /** Array of output segments, set by `align_sections` */
+    ezld_array(ezld_out_seg_t) i_segs;
+    /** Internal object file to which all synthetic sections belong */
+    ezld_obj_t i_synthobj;
+    /** Array of synthetic sections created by the linker */
+    ezld_array(ezld_obj_sec_t *) i_synthsecs;
+    /** Array of SHF_MERGE deduplication states */
+    ezld_array(ezld_mrg_syn_t) i_mrgsyns;
+    /** Array of range-extension thunks */
+    ezld_array(ezld_thunk_t) i_thunks;
+    /** Symbol hash section, or `NULL` if it was not requested */
+    ezld_obj_sec_t *i_symhash;
+    /** Number of global symbols indexed by `i_symhash`, which are the first
+     * ones in `i_globsymtab` */
+    size_t i_symhashlen;
+    /** Section holding the unpacking stub and the compressed segments, or
+     * `NULL` if the image is not compressed */
+    ezld_obj_sec_t *i_unpack;
+    /** Section holding the copy and zero tables, or `NULL` if no load address
+     * was requested */
+    ezld_obj_sec_t *i_copytable;
+    /** Number of entries of the copy table */
+    size_t i_ncopies;
+    /** Dynamic section of a static PIE, or `NULL` for other outputs */
+    ezld_obj_sec_t *i_dynamic;
+    /** Section holding the RELR-packed relative relocations of a static PIE,
+     * or `NULL` for other outputs */
+    ezld_obj_sec_t *i_relrdyn;
+    /** Places of the relative relocations packed into `i_relrdyn` */
+    ezld_array(ezld_reloc_site_t) i_relrs;
+    /** Build ID note section, or `NULL` if no build ID was requested */
+    ezld_obj_sec_t *i_buildid;
+    /** Set of COMDAT group signatures seen so far. Keys point into the string
+     * tables of the object files that defined them */
+    ezld_htab_t i_comdats;
     /** Global symbol table  where all symbols are added */
-    ezld_array(Elf32_Sym) i_globsymtab;
+    ezld_array(ezld_glob_sym_t) i_globsymtab;
     /** Global string table */
     ezld_glob_strtab_t i_globstrtab;
     /** Global section header string table */
     ezld_glob_strtab_t i_shstrtab;
+    /** Strings allocated by the linker and referenced by the string tables */
+    ezld_array(char *) i_ownedstrs;
     /** User configuration */
     ezld_config_t i_cfg;
     /** Pointer to the entry symbol. This field is not set by the user or upon
@@ -362,9 +758,9 @@ const char *arch_name(uint16_t arch) {
     }
 }
 
-EZLD_MAYBE_FUTURE static ezld_mrg_sec_t *find_mrg_sec(size_t name_idx) {
+static ezld_mrg_sec_t *find_mrg_sec(size_t name_idx) {
     for (size_t i = 0; i < g_self->i_mss.len; i++) {
-        ezld_mrg_sec_t *s = &g_self->i_mss.buf[i];
+        ezld_mrg_sec_t *s = g_self->i_mss.buf[i];
 
         if (s->ms_name == name_idx) {
             return s;
@@ -378,7 +774,7 @@ static ezld_glob_str_t shstr_from_idx(size_t shstr_idx) {
     return g_self->i_shstrtab.gst_strs.buf[shstr_idx];
 }
 
-EZLD_MAYBE_FUTURE static ezld_glob_str_t globstr_from_idx(size_t glob_idx) {
+static ezld_glob_str_t globstr_from_idx(size_t glob_idx) {
     return g_self->i_globstrtab.gst_strs.buf[glob_idx];
 }
 
@@ -442,7 +838,7 @@ static size_t resolve_sym(Elf32_Sym      *ret,
     }
 
     if (objsym != NULL && objsym->osy_globndx != EZLD_GLOB_SYM_UNDEF) {
-        *ret = g_self->i_globsymtab.buf[objsym->osy_globndx - 1];
+        *ret = g_self->i_globsymtab.buf[objsym->osy_globndx - 1].gsy_esym;
         return objsym->osy_globndx;
     }
 
@@ -452,7 +848,7 @@ static size_t resolve_sym(Elf32_Sym      *ret,
     }
 
     for (size_t i = 0; i < g_self->i_globsymtab.len; i++) {
-        Elf32_Sym s = g_self->i_globsymtab.buf[i];
+        Elf32_Sym s = g_self->i_globsymtab.buf[i].gsy_esym;
 
         if (s.st_name == glob_stridx) {
             if (objsym != NULL) {
@@ -466,6 +862,78 @@ static size_t resolve_sym(Elf32_Sym      *ret,
     return EZLD_GLOB_SYM_UNDEF;
 }
 
+/**
+ * @return the smallest multiple of `align` greater than or equal to `val`
+ */
+static inline size_t align_up(size_t val, size_t align) {
+    if (align <= 1 || val % align == 0) {
+        return val;
+    }
+
+    return val + (align - (val % align));
+}
+
+/**
+ * @param buf the buffer
+ * @param len the length of the buffer
+ *
+ * @return `true` if all bytes in the buffer are zero, `false` otherwise
+ */
+static bool is_zero(const uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (buf[i] != 0) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Reads the header of a section that is compressed in its object file
+ * and makes the section header describe the uncompressed contents, which are
+ * only inflated if the section is ever read
+ *
+ * @param objsec the compressed section
+ */
+static void read_compressed_header(ezld_obj_sec_t *objsec) {
+    Elf32_Shdr *shdr = &objsec->os_shdr;
+    Elf32_Chdr  chdr = {0};
+
+    if (shdr->sh_size <= sizeof(Elf32_Chdr)) {
+        ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                          "compressed section '%s' in '%s' is truncated",
+                          shstr_from_idx(objsec->os_name).gs_data,
+                          objsec->os_obj->obj_filepath);
+    }
+
+    ezld_runtime_read_exact_at(&chdr,
+                               sizeof(Elf32_Chdr),
+                               shdr->sh_offset,
+                               objsec->os_obj->obj_filepath,
+                               objsec->os_obj->obj_file);
+
+    if (endian32(chdr.ch_type) != ELFCOMPRESS_ZLIB) {
+        ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                          "section '%s' in '%s' uses unsupported compression "
+                          "type %u",
+                          shstr_from_idx(objsec->os_name).gs_data,
+                          objsec->os_obj->obj_filepath,
+                          endian32(chdr.ch_type));
+    }
+
+    objsec->os_zsize = shdr->sh_size - sizeof(Elf32_Chdr);
+    shdr->sh_offset += sizeof(Elf32_Chdr);
+    shdr->sh_size      = endian32(chdr.ch_size);
+    shdr->sh_addralign = endian32(chdr.ch_addralign);
+    shdr->sh_flags &= ~SHF_COMPRESSED;
+    objsec->os_elems = shdr->sh_size;
+
+    if (shdr->sh_entsize != 0) {
+        objsec->os_elems /= shdr->sh_entsize;
+    }
+}
+
 /**
  * @brief Loads the contents of an object file section into the os_data field if
  * it is not been populated yet
@@ -473,7 +941,25 @@ static size_t resolve_sym(Elf32_Sym      *ret,
  * @param sec the object file section pointer
  */
 static void read_section_contents(ezld_obj_sec_t *sec) {
-    if (sec->os_data == NULL) {
+    if (sec->os_data == NULL && sec->os_zsize != 0) {
+        uint8_t *zdata = ezld_runtime_alloc(1, sec->os_zsize);
+        ezld_runtime_read_exact_at(zdata,
+                                   sec->os_zsize,
+                                   sec->os_shdr.sh_offset,
+                                   sec->os_obj->obj_filepath,
+                                   sec->os_obj->obj_file);
+
+        sec->os_data = ezld_runtime_alloc(1, sec->os_shdr.sh_size);
+        if (!ezld_inflate_zlib(
+                sec->os_data, sec->os_shdr.sh_size, zdata, sec->os_zsize)) {
+            ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                              "compressed section '%s' in '%s' is corrupt",
+                              shstr_from_idx(sec->os_name).gs_data,
+                              sec->os_obj->obj_filepath);
+        }
+
+        free(zdata);
+    } else if (sec->os_data == NULL) {
         sec->os_data = ezld_runtime_alloc(1, sec->os_shdr.sh_size);
         ezld_runtime_read_exact_at(sec->os_data,
                                    sec->os_shdr.sh_size,
@@ -484,82 +970,467 @@ static void read_section_contents(ezld_obj_sec_t *sec) {
 }
 
 /**
- * @brief merges an object file section with similar sections in one merged
- * section to be written to the final output file
+ * @brief Rules used to fold input sections into merged sections when none of
+ * the rules given with `--section-map` applies. These cover the names emitted
+ * by compilers with -ffunction-sections and -fdata-sections
+ */
+static const ezld_sec_map_t g_default_secmaps[] = {
+    {.sm_pattern = ".text.*", .sm_output = ".text"},
+    {.sm_pattern = ".rodata.*", .sm_output = ".rodata"},
+    {.sm_pattern = ".srodata.*", .sm_output = ".srodata"},
+    {.sm_pattern = ".data.*", .sm_output = ".data"},
+    {.sm_pattern = ".sdata.*", .sm_output = ".sdata"},
+    {.sm_pattern = ".bss.*", .sm_output = ".bss"},
+    {.sm_pattern = ".sbss.*", .sm_output = ".sbss"}};
+
+/**
+ * @param name the name of an object file section
  *
- * @param objsec the object file section pointer
+ * @return the name of the merged section into which the object file section
+ * is to be folded
  */
-static void merge_section(ezld_obj_sec_t *objsec) {
-    size_t      objsec_name     = objsec->os_name;
-    const char *objsec_name_str = shstr_from_idx(objsec_name).gs_data;
+static const char *output_section_name(const char *name) {
+    for (size_t i = 0; i < g_self->i_cfg.cfg_secmaps.len; i++) {
+        ezld_sec_map_t *map = &g_self->i_cfg.cfg_secmaps.buf[i];
+        if (ezld_runtime_glob_match(map->sm_pattern, name)) {
+            return map->sm_output;
+        }
+    }
 
-    for (size_t i = 0; i < g_self->i_mss.len; i++) {
-        ezld_mrg_sec_t *mrg = &g_self->i_mss.buf[i];
+    // Partial links keep the input names, so that the final link can still
+    // place or discard the sections one by one
+    if (g_self->i_cfg.cfg_relocatable) {
+        return name;
+    }
+
+    for (size_t i = 0; i < sizeof g_default_secmaps / sizeof *g_default_secmaps;
+         i++) {
+        if (ezld_runtime_glob_match(g_default_secmaps[i].sm_pattern, name)) {
+            return g_default_secmaps[i].sm_output;
+        }
+    }
+
+    return name;
+}
 
-        if (mrg->ms_name != objsec_name) {
+/**
+ * @brief Recognizes the names compilers give to hot, cold, and startup-only
+ * sections, such as `.text.hot.foo` or `.data.unlikely`
+ *
+ * @param name the name of the object file section
+ *
+ * @return one of the `EZLD_RANK_*` values
+ */
+static size_t section_rank(const char *name) {
+    static const char *const bases[] = {".text", ".rodata", ".data", ".bss"};
+    static const struct {
+        const char *sr_suffix;
+        size_t      sr_rank;
+    } ranks[] = {{".hot", EZLD_RANK_HOT},
+                 {".startup", EZLD_RANK_STARTUP},
+                 {".unlikely", EZLD_RANK_UNLIKELY}};
+
+    for (size_t i = 0; i < sizeof bases / sizeof *bases; i++) {
+        size_t base_len = strlen(bases[i]);
+        if (strncmp(name, bases[i], base_len) != 0) {
             continue;
         }
 
-        size_t next_idx = mrg->ms_oss.len;
+        for (size_t j = 0; j < sizeof ranks / sizeof *ranks; j++) {
+            const char *suffix     = ranks[j].sr_suffix;
+            size_t      suffix_len = strlen(suffix);
 
-        if (ezld_array_is_empty(mrg->ms_oss)) {
-            *ezld_array_push(mrg->ms_oss) = objsec;
-            objsec->os_ndx                = next_idx;
-            objsec->os_mrg                = mrg;
-            objsec->os_transl             = 0;
-            mrg->ms_memsz                 = objsec->os_shdr.sh_size;
-            return;
+            if (strncmp(name + base_len, suffix, suffix_len) == 0 &&
+                (name[base_len + suffix_len] == '\0' ||
+                 name[base_len + suffix_len] == '.')) {
+                return ranks[j].sr_rank;
+            }
         }
+    }
+
+    return EZLD_RANK_DEFAULT;
+}
+
+/**
+ * @brief Creates a new, empty merged section
+ *
+ * @param name_idx the index of the name of the section in the section header
+ * string table
+ *
+ * @return the new merged section, which is appended to `g_self->i_mss`
+ */
+static ezld_mrg_sec_t *new_mrg_sec(size_t name_idx) {
+    ezld_mrg_sec_t *mrg = ezld_runtime_alloc(sizeof(ezld_mrg_sec_t), 1);
+    mrg->ms_name        = name_idx;
+    mrg->ms_ndx         = g_self->i_mss.len;
+    mrg->ms_vaddr       = 0;
+    mrg->ms_reqvaddr    = 0;
+    mrg->ms_paddr       = 0;
+    mrg->ms_reqpaddr    = 0;
+    mrg->ms_memsz       = 0;
+    mrg->ms_fileoff     = 0;
+    mrg->ms_shdr        = (Elf32_Shdr){0};
+    mrg->ms_outndx      = 0;
+    mrg->ms_symndx      = 0;
+    mrg->ms_zdata       = NULL;
+    mrg->ms_zsize       = 0;
+    ezld_array_init(mrg->ms_oss);
+    ezld_array_init(mrg->ms_relas);
+    *ezld_array_push(g_self->i_mss) = mrg;
+    return mrg;
+}
+
+/**
+ * @brief merges an object file section with similar sections in one merged
+ * section to be written to the final output file. The position of the section
+ * inside the merged section is decided later by `layout_sections`
+ *
+ * @param objsec the object file section pointer
+ */
+static void merge_section(ezld_obj_sec_t *objsec) {
+    const char     *objsec_name_str = shstr_from_idx(objsec->os_name).gs_data;
+    size_t          mrg_name = shstr_add(output_section_name(objsec_name_str));
+    ezld_mrg_sec_t *mrg      = find_mrg_sec(mrg_name);
+    Elf32_Shdr      shdr     = objsec->os_shdr;
+    shdr.sh_flags &= ~EZLD_SHF_INPUT_ONLY;
+    objsec->os_rank = section_rank(objsec_name_str);
+
+    // Partial links keep mergeable sections mergeable, as long as all inputs
+    // agree on the entry size and no padding ends up in the middle of entries
+    uint32_t merge_flags =
+        objsec->os_shdr.sh_flags & (SHF_MERGE | SHF_STRINGS);
+    size_t entsize   = objsec->os_shdr.sh_entsize;
+    size_t align     = objsec->os_shdr.sh_addralign;
+    bool   mergeable = g_self->i_cfg.cfg_relocatable &&
+                     (merge_flags & SHF_MERGE) && entsize != 0 &&
+                     (align <= 1 || entsize % align == 0);
+
+    if (mrg == NULL) {
+        mrg = new_mrg_sec(mrg_name);
+    }
 
-        ezld_obj_sec_t *last = ezld_array_last(mrg->ms_oss);
+    if (ezld_array_is_empty(mrg->ms_oss)) {
+        mrg->ms_shdr = (Elf32_Shdr){.sh_type  = shdr.sh_type,
+                                    .sh_flags = shdr.sh_flags};
 
-        if (objsec->os_shdr.sh_type != last->os_shdr.sh_type) {
+        if (mergeable) {
+            mrg->ms_shdr.sh_flags |= merge_flags;
+            mrg->ms_shdr.sh_entsize = entsize;
+        }
+    } else {
+        if (shdr.sh_type != mrg->ms_shdr.sh_type) {
             ezld_runtime_exit(EZLD_ECODE_BADSEC,
                               "section '%s' in '%s' has conflicting type "
                               "with '%s' sections in other files",
                               objsec_name_str,
                               objsec->os_obj->obj_filepath,
-                              objsec_name_str);
+                              shstr_from_idx(mrg->ms_name).gs_data);
         }
 
-        if (objsec->os_shdr.sh_flags != last->os_shdr.sh_flags) {
+        if (shdr.sh_flags != (mrg->ms_shdr.sh_flags & ~EZLD_SHF_INPUT_ONLY)) {
             ezld_runtime_exit(EZLD_ECODE_BADSEC,
                               "section '%s' in '%s' has conflicting flags "
                               "with '%s' sections in other files",
                               objsec_name_str,
                               objsec->os_obj->obj_filepath,
-                              objsec_name_str);
+                              shstr_from_idx(mrg->ms_name).gs_data);
         }
 
-        if (objsec->os_shdr.sh_addralign != last->os_shdr.sh_addralign) {
-            ezld_runtime_exit(EZLD_ECODE_BADSEC,
-                              "section '%s' in '%s' has conflicting alignment "
-                              "with '%s' sections in other files",
-                              objsec_name_str,
-                              objsec->os_obj->obj_filepath,
-                              objsec_name_str);
+        if (!mergeable ||
+            (mrg->ms_shdr.sh_flags & (SHF_MERGE | SHF_STRINGS)) !=
+                merge_flags ||
+            mrg->ms_shdr.sh_entsize != entsize) {
+            mrg->ms_shdr.sh_flags &= ~(SHF_MERGE | SHF_STRINGS);
+            mrg->ms_shdr.sh_entsize = 0;
         }
+    }
 
-        size_t transl_off             = last->os_transl + last->os_shdr.sh_size;
-        *ezld_array_push(mrg->ms_oss) = objsec;
-        objsec->os_ndx                = next_idx;
-        objsec->os_mrg                = mrg;
-        objsec->os_transl             = transl_off;
-        mrg->ms_memsz += objsec->os_shdr.sh_size;
-        return;
+    objsec->os_ndx                = mrg->ms_oss.len;
+    objsec->os_mrg                = mrg;
+    objsec->os_transl             = 0;
+    *ezld_array_push(mrg->ms_oss) = objsec;
+}
+
+/**
+ * @brief Creates a new section owned by the linker itself
+ *
+ * @param name the name of the section
+ * @param shdr the section header of the section
+ *
+ * @return the new section, which is not part of any merged section yet
+ */
+static ezld_obj_sec_t *new_synth_section(const char *name, Elf32_Shdr shdr) {
+    ezld_obj_sec_t *synth = ezld_runtime_alloc(sizeof(ezld_obj_sec_t), 1);
+    synth->os_obj         = &g_self->i_synthobj;
+    synth->os_shdr        = shdr;
+    synth->os_elems       = shdr.sh_size;
+    synth->os_transl      = 0;
+    synth->os_mrg         = NULL;
+    synth->os_ndx         = 0;
+    synth->os_data        = NULL;
+    synth->os_name        = shstr_add(name);
+    synth->os_mrgsyn      = NULL;
+    synth->os_discarded   = false;
+    synth->os_order       = EZLD_ORDER_NONE;
+    synth->os_rank        = EZLD_RANK_DEFAULT;
+    synth->os_island      = NULL;
+    synth->os_zsize       = 0;
+    ezld_array_init(synth->os_pieces);
+    ezld_array_init(synth->os_drelocs);
+    *ezld_array_push(g_self->i_synthsecs) = synth;
+    return synth;
+}
+
+/**
+ * @brief Finds (or creates) the deduplication state for the synthetic section
+ * into which a given SHF_MERGE section shall be merged
+ *
+ * @param objsec the object file section pointer
+ *
+ * @return the deduplication state
+ */
+static ezld_mrg_syn_t *find_mrg_syn(ezld_obj_sec_t *objsec) {
+    for (size_t i = 0; i < g_self->i_mrgsyns.len; i++) {
+        ezld_mrg_syn_t *msy = &g_self->i_mrgsyns.buf[i];
+        Elf32_Shdr      sh  = msy->msy_os->os_shdr;
+
+        if (msy->msy_os->os_name == objsec->os_name &&
+            sh.sh_flags == objsec->os_shdr.sh_flags &&
+            sh.sh_entsize == objsec->os_shdr.sh_entsize) {
+            return msy;
+        }
+    }
+
+    Elf32_Shdr shdr = objsec->os_shdr;
+    shdr.sh_size    = 0;
+    shdr.sh_offset  = 0;
+
+    ezld_mrg_syn_t *msy = ezld_array_push(g_self->i_mrgsyns);
+    msy->msy_os         = new_synth_section(
+        shstr_from_idx(objsec->os_name).gs_data, shdr);
+    ezld_htab_init(msy->msy_htab);
+    ezld_array_init(msy->msy_data);
+    merge_section(msy->msy_os);
+    return msy;
+}
+
+/**
+ * @brief Splits an SHF_MERGE section into pieces and deduplicates them into
+ * the relevant synthetic section. Pieces are fixed-size entries of
+ * `sh_entsize` bytes or, if the section also has the SHF_STRINGS flag,
+ * null-terminated strings of `sh_entsize`-byte characters
+ *
+ * @param objsec the object file section pointer
+ */
+static void merge_mergeable(ezld_obj_sec_t *objsec) {
+    const char *name    = shstr_from_idx(objsec->os_name).gs_data;
+    size_t      size    = objsec->os_shdr.sh_size;
+    size_t      entsize = objsec->os_shdr.sh_entsize;
+    bool        strings = objsec->os_shdr.sh_flags & SHF_STRINGS;
+
+    if (!strings && size % entsize != 0) {
+        ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                          "section '%s' in '%s' has size %zu, which is not a "
+                          "multiple of its entry size %zu",
+                          name,
+                          objsec->os_obj->obj_filepath,
+                          size,
+                          entsize);
+    }
+
+    read_section_contents(objsec);
+    ezld_mrg_syn_t *msy   = find_mrg_syn(objsec);
+    ezld_obj_sec_t *synth = msy->msy_os;
+    objsec->os_mrgsyn     = synth;
+    objsec->os_mrg        = synth->os_mrg;
+    objsec->os_ndx        = 0;
+    objsec->os_transl     = 0;
+
+    if (objsec->os_shdr.sh_addralign > synth->os_shdr.sh_addralign) {
+        synth->os_shdr.sh_addralign = objsec->os_shdr.sh_addralign;
+    }
+
+    for (size_t start = 0; start < size;) {
+        size_t end = start + entsize;
+
+        if (strings) {
+            while (end <= size &&
+                   !is_zero(&objsec->os_data[end - entsize], entsize)) {
+                end += entsize;
+            }
+
+            if (end > size) {
+                ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                                  "string at offset 0x%zx in section '%s' in "
+                                  "'%s' is not null-terminated",
+                                  start,
+                                  name,
+                                  objsec->os_obj->obj_filepath);
+            }
+        }
+
+        // Pieces keep the largest alignment they had in the object file, up
+        // to the alignment of the section
+        size_t align = objsec->os_shdr.sh_addralign;
+        while (align > 1 && start % align != 0) {
+            align >>= 1;
+        }
+
+        size_t outoff = msy->msy_data.len;
+        if (align > 1 && outoff % align != 0) {
+            outoff += align - (outoff % align);
+        }
+
+        size_t found = outoff;
+        if (ezld_htab_put(&msy->msy_htab,
+                          &objsec->os_data[start],
+                          end - start,
+                          &found) &&
+            (align <= 1 || found % align == 0)) {
+            outoff = found;
+        } else {
+            while (msy->msy_data.len < outoff) {
+                *ezld_array_push(msy->msy_data) = 0;
+            }
+
+            for (size_t i = start; i < end; i++) {
+                *ezld_array_push(msy->msy_data) = objsec->os_data[i];
+            }
+        }
+
+        ezld_sec_piece_t *piece = ezld_array_push(objsec->os_pieces);
+        piece->sp_inoff         = start;
+        piece->sp_outoff        = outoff;
+        start                   = end;
+    }
+}
+
+/**
+ * @brief Hands the deduplicated contents of SHF_MERGE sections over to the
+ * relevant synthetic sections. This must be called after all object files have
+ * been read
+ */
+static void finalize_mergeables(void) {
+    for (size_t i = 0; i < g_self->i_mrgsyns.len; i++) {
+        ezld_mrg_syn_t *msy        = &g_self->i_mrgsyns.buf[i];
+        ezld_obj_sec_t *synth      = msy->msy_os;
+        synth->os_data             = msy->msy_data.buf;
+        synth->os_shdr.sh_size     = msy->msy_data.len;
+        synth->os_elems            = msy->msy_data.len;
+        ezld_array_init(msy->msy_data);
+        ezld_htab_free(&msy->msy_htab);
+
+        if (synth->os_shdr.sh_entsize != 0) {
+            synth->os_elems /= synth->os_shdr.sh_entsize;
+        }
+    }
+}
+
+/**
+ * @brief Translates an offset into an object file section into an offset into
+ * the merged section of which it is part
+ *
+ * @param os the object file section
+ * @param off the offset into the object file section
+ *
+ * @return the offset into `os.os_mrg`
+ */
+static size_t translate_off(ezld_obj_sec_t *os, size_t off) {
+    if (os->os_mrgsyn == NULL) {
+        return os->os_transl + off;
+    }
+
+    size_t lo = 0;
+    size_t hi = os->os_pieces.len;
+
+    // Find the last piece that starts at or before `off`
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+
+        if (os->os_pieces.buf[mid].sp_inoff <= off) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    ezld_sec_piece_t piece = os->os_pieces.buf[lo];
+    return os->os_mrgsyn->os_transl + piece.sp_outoff + (off - piece.sp_inoff);
+}
+
+/**
+ * @return the alignment of an object file section, at least 1
+ */
+static size_t section_align(const ezld_obj_sec_t *os) {
+    return (os->os_shdr.sh_addralign > 1) ? os->os_shdr.sh_addralign : 1;
+}
+
+/**
+ * @brief qsort comparator for pointers to object file sections, sorting by
+ * `os_rank` first, `os_order` second, by decreasing alignment if requested,
+ * and by input order (`os_ndx`) then
+ */
+static int compare_sections(const void *a, const void *b) {
+    const ezld_obj_sec_t *sa = *(ezld_obj_sec_t *const *)a;
+    const ezld_obj_sec_t *sb = *(ezld_obj_sec_t *const *)b;
+
+    if (sa->os_rank != sb->os_rank) {
+        return (sa->os_rank < sb->os_rank) ? -1 : 1;
+    }
+
+    if (sa->os_order != sb->os_order) {
+        return (sa->os_order < sb->os_order) ? -1 : 1;
+    }
+
+    // Placing sections with larger alignments first means that no padding is
+    // needed between sections with power of two alignments
+    if (g_self->i_cfg.cfg_sortalign && section_align(sa) != section_align(sb)) {
+        return (section_align(sa) > section_align(sb)) ? -1 : 1;
     }
 
-    size_t          next_mrg_idx = g_self->i_mss.len;
-    ezld_mrg_sec_t *new_mrg      = ezld_array_push(g_self->i_mss);
-    new_mrg->ms_name             = objsec_name;
-    new_mrg->ms_ndx              = next_mrg_idx;
-    new_mrg->ms_memsz            = 0;
-    new_mrg->ms_fileoff          = 0;
-    ezld_array_init(new_mrg->ms_oss);
-    objsec->os_ndx                    = 0;
-    objsec->os_mrg                    = new_mrg;
-    objsec->os_transl                 = 0;
-    *ezld_array_push(new_mrg->ms_oss) = objsec;
+    return (sa->os_ndx > sb->os_ndx) - (sa->os_ndx < sb->os_ndx);
+}
+
+/**
+ * @brief Computes the position of all object file sections inside their merged
+ * sections and the resulting size and alignment of the merged sections. Each
+ * object file section is placed at an offset that is a multiple of its own
+ * alignment
+ */
+static void layout_sections(void) {
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg    = g_self->i_mss.buf[i];
+        size_t          transl = 0;
+        size_t          align  = 1;
+
+        // os_ndx still holds the input order here
+        if (mrg->ms_oss.len > 1) {
+            qsort(mrg->ms_oss.buf,
+                  mrg->ms_oss.len,
+                  sizeof(ezld_obj_sec_t *),
+                  compare_sections);
+        }
+
+        for (size_t j = 0; j < mrg->ms_oss.len; j++) {
+            ezld_obj_sec_t *os = mrg->ms_oss.buf[j];
+            os->os_ndx         = j;
+            os->os_transl      = align_up(transl, section_align(os));
+            transl             = os->os_transl + os->os_shdr.sh_size;
+
+            if (section_align(os) > align) {
+                align = section_align(os);
+            }
+
+            if (os->os_island != NULL) {
+                ezld_obj_sec_t *island = os->os_island;
+                island->os_transl = align_up(transl, section_align(island));
+                transl = island->os_transl + island->os_shdr.sh_size;
+            }
+        }
+
+        mrg->ms_memsz             = transl;
+        mrg->ms_shdr.sh_addralign = align;
+    }
 }
 
 static Elf32_Shdr endian_shdr(Elf32_Shdr shdr) {
@@ -584,6 +1455,13 @@ static Elf32_Sym endian_sym(Elf32_Sym sym) {
     return sym;
 }
 
+static Elf32_Rela endian_rela(Elf32_Rela rela) {
+    rela.r_offset = endian32(rela.r_offset);
+    rela.r_info   = endian32(rela.r_info);
+    rela.r_addend = endian32(rela.r_addend);
+    return rela;
+}
+
 static Elf32_Ehdr endian_ehdr(Elf32_Ehdr ehdr) {
     ehdr.e_type      = endian16(ehdr.e_type);
     ehdr.e_machine   = endian16(ehdr.e_machine);
@@ -751,6 +1629,8 @@ static void merge_symtabs(ezld_obj_t *obj) {
         ezld_obj_sym_t *obj_sym = ezld_array_push(obj->obj_ost.ost_syms);
         obj_sym->osy_esym       = entry;
         obj_sym->osy_name       = (char *)&strtab_sec->os_data[entry.st_name];
+        obj_sym->osy_globndx    = EZLD_GLOB_SYM_UNDEF;
+        obj_sym->osy_outndx     = 0;
 
         if (entry.st_shndx >= obj->obj_oss.len &&
             entry.st_shndx < SHN_LORESERVE) {
@@ -775,7 +1655,16 @@ static void merge_symtabs(ezld_obj_t *obj) {
             continue;
         }
 
-        if (entry.st_name >= SHN_LORESERVE) {
+        // Definitions in discarded COMDAT group members are turned into
+        // references to the definition in the group instance that was kept
+        if (entry.st_shndx < obj->obj_oss.len &&
+            obj->obj_oss.buf[entry.st_shndx].os_discarded) {
+            obj_sym->osy_esym.st_shndx = SHN_UNDEF;
+            obj_sym->osy_globndx       = EZLD_GLOB_SYM_UNDEF;
+            continue;
+        }
+
+        if (entry.st_shndx >= SHN_LORESERVE) {
             ezld_runtime_exit(
                 EZLD_ECODE_BADSYM,
                 "symbol '%s' in '%s' uses unsupported special section",
@@ -783,7 +1672,8 @@ static void merge_symtabs(ezld_obj_t *obj) {
                 obj->obj_filepath);
         }
 
-        if (ELF32_ST_BIND(entry.st_info) != STB_GLOBAL) {
+        if (ELF32_ST_BIND(entry.st_info) != STB_GLOBAL &&
+            ELF32_ST_BIND(entry.st_info) != STB_WEAK) {
             ezld_runtime_exit(EZLD_ECODE_BADSYM,
                               "symbol '%s' in '%s' uses unsupported binding",
                               obj_sym->osy_name,
@@ -792,61 +1682,275 @@ static void merge_symtabs(ezld_obj_t *obj) {
 
         size_t glob_strndx = globstr_add(obj_sym->osy_name);
         size_t glob_symndx = resolve_sym(NULL, obj_sym, glob_strndx, false);
+        bool   is_weak     = ELF32_ST_BIND(entry.st_info) == STB_WEAK;
 
         if (glob_symndx != EZLD_GLOB_SYM_UNDEF) {
-            ezld_runtime_exit(EZLD_ECODE_BADSYM,
-                              "multiple definitions of symbol '%s'",
-                              obj_sym->osy_name);
+            Elf32_Sym prev = g_self->i_globsymtab.buf[glob_symndx - 1].gsy_esym;
+
+            // The first weak definition is used unless a strong one is found
+            if (is_weak) {
+                continue;
+            }
+
+            if (ELF32_ST_BIND(prev.st_info) != STB_WEAK) {
+                ezld_runtime_exit(EZLD_ECODE_BADSYM,
+                                  "multiple definitions of symbol '%s'",
+                                  obj_sym->osy_name);
+            }
         }
 
         ezld_obj_sec_t *sym_sec =
             &obj_symtab->os_obj->obj_oss.buf[entry.st_shndx];
-        size_t     glob_shidx = sym_sec->os_mrg->ms_ndx;
-        Elf32_Sym *glob_sym   = ezld_array_push(g_self->i_globsymtab);
 
+        if (sym_sec->os_mrg == NULL) {
+            ezld_runtime_exit(EZLD_ECODE_BADSYM,
+                              "symbol '%s' in '%s' is defined in a section "
+                              "that is not part of the output",
+                              obj_sym->osy_name,
+                              obj->obj_filepath);
+        }
+
+        if (glob_symndx == EZLD_GLOB_SYM_UNDEF) {
+            (void)ezld_array_push(g_self->i_globsymtab);
+            glob_symndx = g_self->i_globsymtab.len;
+        }
+
+        size_t           glob_shidx = sym_sec->os_mrg->ms_ndx;
+        ezld_glob_sym_t *glob_gsym =
+            &g_self->i_globsymtab.buf[glob_symndx - 1];
+        Elf32_Sym *glob_sym = &glob_gsym->gsy_esym;
+        glob_gsym->gsy_os   = sym_sec;
+        glob_gsym->gsy_off  = entry.st_value;
+
+        // The value stays relative to the object file section until
+        // virtualize_syms, since the final layout is not known yet
         glob_sym->st_shndx = glob_shidx;
-        glob_sym->st_value = entry.st_value + sym_sec->os_transl;
+        glob_sym->st_value = entry.st_value;
         glob_sym->st_name  = glob_strndx;
         glob_sym->st_size  = entry.st_size;
         glob_sym->st_info  = entry.st_info;
+        glob_sym->st_other = entry.st_other;
 
         // This starts at 1 to use 0 as NULL
-        obj_sym->osy_globndx = g_self->i_globsymtab.len;
+        obj_sym->osy_globndx = glob_symndx;
 
         // We can compare indices directly because duplicate strings get
         // collapsed by globstr_add so if the index matches, the contents will
         // match too
-        if (g_self->i_osentry == NULL && glob_sym->st_name == EZLD_ENTRY_NAME &&
-            ELF32_ST_BIND(entry.st_info) == STB_GLOBAL) {
+        if (g_self->i_osentry == NULL && glob_sym->st_name == EZLD_ENTRY_NAME) {
             g_self->i_osentry = obj_sym;
         }
     }
 }
 
 /**
- * @brief Runs the first stage of linking on a given object file
+ * @brief Reads a section group and, if it is a COMDAT group whose signature was
+ * already seen in a previous object file, discards all its members. Otherwise,
+ * the signature is recorded and the members are kept
  *
  * @param obj the object file
+ * @param grpsec the SHT_GROUP section
  */
-static void read_object(ezld_obj_t *obj) {
-    ezld_array_init(obj->obj_oss);
-    obj->obj_ost.ost_os = NULL;
-    ezld_array_init(obj->obj_ost.ost_syms);
+static void read_group(ezld_obj_t *obj, ezld_obj_sec_t *grpsec) {
+    Elf32_Shdr shdr = grpsec->os_shdr;
 
-    Elf32_Ehdr ehdr = {0};
-    ezld_runtime_read_exact(
-        &ehdr, sizeof(Elf32_Ehdr), obj->obj_filepath, obj->obj_file);
-    obj->obj_ehdr = ehdr;
-
-    if (ehdr.e_ident[EI_MAG0] != ELFMAG0 || ehdr.e_ident[EI_MAG1] != ELFMAG1 ||
-        ehdr.e_ident[EI_MAG2] != ELFMAG2 || ehdr.e_ident[EI_MAG3] != ELFMAG3) {
-        ezld_runtime_exit(
-            EZLD_ECODE_BADFILE, "'%s' is not an ELF file", obj->obj_filepath);
+    if (shdr.sh_link >= obj->obj_oss.len ||
+        obj->obj_oss.buf[shdr.sh_link].os_shdr.sh_type != SHT_SYMTAB) {
+        ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                          "section group in '%s' references invalid symbol "
+                          "table number 0x%x",
+                          obj->obj_filepath,
+                          shdr.sh_link);
     }
 
-    if (ehdr.e_ident[EI_CLASS] != ELFCLASS32) {
-        ezld_runtime_exit(
-            EZLD_ECODE_BADFILE, "'%s' is not a 32-bit ELF", obj->obj_filepath);
+    if (shdr.sh_size < sizeof(Elf32_Word) ||
+        shdr.sh_size % sizeof(Elf32_Word) != 0) {
+        ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                          "section group in '%s' has invalid size %zu",
+                          obj->obj_filepath,
+                          shdr.sh_size);
+    }
+
+    read_section_contents(grpsec);
+    Elf32_Word *words = (Elf32_Word *)grpsec->os_data;
+
+    if (!(endian32(words[0]) & GRP_COMDAT)) {
+        return;
+    }
+
+    // The signature is the name of the symbol referenced by sh_info
+    ezld_obj_sec_t *symtab = &obj->obj_oss.buf[shdr.sh_link];
+
+    if (symtab->os_shdr.sh_link >= obj->obj_oss.len ||
+        shdr.sh_info >= symtab->os_elems) {
+        ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                          "section group in '%s' references invalid "
+                          "signature symbol number 0x%x",
+                          obj->obj_filepath,
+                          shdr.sh_info);
+    }
+
+    ezld_obj_sec_t *strtab = &obj->obj_oss.buf[symtab->os_shdr.sh_link];
+    Elf32_Sym       sig    = {0};
+    ezld_runtime_read_exact_at(&sig,
+                               sizeof(Elf32_Sym),
+                               symtab->os_shdr.sh_offset +
+                                   shdr.sh_info * sizeof(Elf32_Sym),
+                               obj->obj_filepath,
+                               obj->obj_file);
+    sig = endian_sym(sig);
+    read_section_contents(strtab);
+
+    if (sig.st_name >= strtab->os_shdr.sh_size) {
+        ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                          "section group in '%s' has invalid signature name",
+                          obj->obj_filepath);
+    }
+
+    const char *sig_name = (const char *)&strtab->os_data[sig.st_name];
+    size_t      owner    = obj->obj_ndx;
+    bool        dup      = ezld_htab_put(
+        &g_self->i_comdats, sig_name, strlen(sig_name), &owner);
+    size_t num_members = shdr.sh_size / sizeof(Elf32_Word) - 1;
+
+    for (size_t i = 0; i < num_members; i++) {
+        size_t member_idx = endian32(words[i + 1]);
+
+        if (member_idx >= obj->obj_oss.len) {
+            ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                              "section group '%s' in '%s' references invalid "
+                              "section number 0x%zx",
+                              sig_name,
+                              obj->obj_filepath,
+                              member_idx);
+        }
+
+        ezld_obj_sec_t *member = &obj->obj_oss.buf[member_idx];
+
+        if (dup) {
+            member->os_discarded = true;
+        } else {
+            // Group membership is consumed here, so that members can be
+            // merged with sections of the same name outside the group
+            member->os_shdr.sh_flags &= ~SHF_GROUP;
+        }
+    }
+}
+
+/**
+ * @brief Tells whether an object file section is dropped by `--strip-debug`,
+ * `--strip-all`, or `--discard-section`. Only sections that would be merged
+ * into the output are considered, and only by name and flags, so that dropped
+ * sections are never read
+ *
+ * @param objsec the object file section
+ *
+ * @return `true` if the section is to be discarded
+ */
+static bool is_stripped(ezld_obj_sec_t *objsec) {
+    static const char *const debug_patterns[] = {
+        ".debug*", ".zdebug*", ".line", ".stab*", ".gnu.linkonce.wi.*"};
+
+    Elf32_Shdr  shdr = objsec->os_shdr;
+    const char *name = shstr_from_idx(objsec->os_name).gs_data;
+
+    if (shdr.sh_type != SHT_PROGBITS && shdr.sh_type != SHT_NOBITS) {
+        return false;
+    }
+
+    for (size_t i = 0; i < g_self->i_cfg.cfg_discards.len; i++) {
+        if (ezld_runtime_glob_match(g_self->i_cfg.cfg_discards.buf[i], name)) {
+            return true;
+        }
+    }
+
+    if (shdr.sh_flags & SHF_ALLOC) {
+        return false;
+    }
+
+    if (g_self->i_cfg.cfg_stripall) {
+        return true;
+    }
+
+    for (size_t i = 0;
+         g_self->i_cfg.cfg_stripdebug &&
+         i < sizeof debug_patterns / sizeof *debug_patterns;
+         i++) {
+        if (ezld_runtime_glob_match(debug_patterns[i], name)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Moves an initialized data section whose contents are all zeros to
+ * the zero-initialized section that corresponds to its output section
+ * (`.data` to `.bss`, `.sdata` to `.sbss`), so that it takes no room in the
+ * output file. Sections folded elsewhere by `--section-map` are left alone
+ *
+ * @param objsec the object file section, not merged yet
+ * @param relocated `true` if relocations apply to the section, whose contents
+ * may thus not stay zero
+ */
+static void zero_data_to_bss(ezld_obj_sec_t *objsec, bool relocated) {
+    static const struct {
+        const char *zd_data;
+        const char *zd_bss;
+    } pairs[] = {{".data", ".bss"}, {".sdata", ".sbss"}};
+
+    Elf32_Shdr shdr = objsec->os_shdr;
+
+    if (g_self->i_cfg.cfg_relocatable || relocated ||
+        shdr.sh_type != SHT_PROGBITS || shdr.sh_size == 0 ||
+        (shdr.sh_flags & (SHF_ALLOC | SHF_WRITE)) != (SHF_ALLOC | SHF_WRITE) ||
+        (shdr.sh_flags & (SHF_EXECINSTR | SHF_MERGE | SHF_TLS))) {
+        return;
+    }
+
+    const char *out_name =
+        output_section_name(shstr_from_idx(objsec->os_name).gs_data);
+
+    for (size_t i = 0; i < sizeof pairs / sizeof *pairs; i++) {
+        if (strcmp(out_name, pairs[i].zd_data) != 0) {
+            continue;
+        }
+
+        read_section_contents(objsec);
+        if (is_zero(objsec->os_data, shdr.sh_size)) {
+            objsec->os_shdr.sh_type = SHT_NOBITS;
+            objsec->os_name         = shstr_add(pairs[i].zd_bss);
+        }
+
+        return;
+    }
+}
+
+/**
+ * @brief Runs the first stage of linking on a given object file
+ *
+ * @param obj the object file
+ */
+static void read_object(ezld_obj_t *obj) {
+    ezld_array_init(obj->obj_oss);
+    obj->obj_ost.ost_os = NULL;
+    ezld_array_init(obj->obj_ost.ost_syms);
+
+    Elf32_Ehdr ehdr = {0};
+    ezld_runtime_read_exact(
+        &ehdr, sizeof(Elf32_Ehdr), obj->obj_filepath, obj->obj_file);
+    obj->obj_ehdr = ehdr;
+
+    if (ehdr.e_ident[EI_MAG0] != ELFMAG0 || ehdr.e_ident[EI_MAG1] != ELFMAG1 ||
+        ehdr.e_ident[EI_MAG2] != ELFMAG2 || ehdr.e_ident[EI_MAG3] != ELFMAG3) {
+        ezld_runtime_exit(
+            EZLD_ECODE_BADFILE, "'%s' is not an ELF file", obj->obj_filepath);
+    }
+
+    if (ehdr.e_ident[EI_CLASS] != ELFCLASS32) {
+        ezld_runtime_exit(
+            EZLD_ECODE_BADFILE, "'%s' is not a 32-bit ELF", obj->obj_filepath);
     }
 
     uint16_t obj_arch = endian16(ehdr.e_machine);
@@ -885,6 +1989,10 @@ static void read_object(ezld_obj_t *obj) {
 
     char *shstrtab = read_strtab(obj, ehdr.e_shstrndx);
 
+    // Sections are referenced by pointer from now on, so the array must never
+    // be reallocated
+    ezld_array_alloc(obj->obj_oss, ehdr.e_shnum);
+
     ezld_runtime_seek(ehdr.e_shoff, obj->obj_filepath, obj->obj_file);
     for (size_t i = 0; i < ehdr.e_shnum; i++) {
         Elf32_Shdr  shdr        = read_shdr(0, false, obj);
@@ -894,8 +2002,19 @@ static void read_object(ezld_obj_t *obj) {
         objsec->os_obj         = obj;
         objsec->os_shdr        = shdr;
         objsec->os_elems       = shdr.sh_size;
+        objsec->os_transl      = 0;
+        objsec->os_mrg         = NULL;
+        objsec->os_ndx         = 0;
         objsec->os_data        = NULL;
         objsec->os_name        = shstr_add(objsec_name);
+        objsec->os_mrgsyn      = NULL;
+        objsec->os_discarded   = false;
+        objsec->os_order       = EZLD_ORDER_NONE;
+        objsec->os_rank        = EZLD_RANK_DEFAULT;
+        objsec->os_island      = NULL;
+        objsec->os_zsize       = 0;
+        ezld_array_init(objsec->os_pieces);
+        ezld_array_init(objsec->os_drelocs);
 
         if (shdr.sh_entsize != 0) {
             objsec->os_elems /= shdr.sh_entsize;
@@ -917,11 +2036,70 @@ static void read_object(ezld_obj_t *obj) {
                 objsec->os_mrg      = NULL;
                 objsec->os_ndx      = 0;
             }
+        }
+    }
+
+    // Groups must be processed before merging, so that sections of duplicate
+    // groups are never read
+    for (size_t i = 0; i < obj->obj_oss.len; i++) {
+        if (obj->obj_oss.buf[i].os_shdr.sh_type == SHT_GROUP) {
+            read_group(obj, &obj->obj_oss.buf[i]);
+        }
+    }
+
+    for (size_t i = 0; i < obj->obj_oss.len; i++) {
+        ezld_obj_sec_t *objsec = &obj->obj_oss.buf[i];
+
+        if (!objsec->os_discarded && is_stripped(objsec)) {
+            objsec->os_discarded = true;
+        }
+    }
+
+    // Sections that relocations apply to can not be told to be all zeros
+    // until relocations are applied. Relocations for discarded sections are
+    // discarded as well, so that they are never read either
+    bool *relocated = ezld_runtime_alloc(sizeof(bool), obj->obj_oss.len + 1);
+    memset(relocated, 0, obj->obj_oss.len * sizeof(bool));
+
+    for (size_t i = 0; i < obj->obj_oss.len; i++) {
+        ezld_obj_sec_t *objsec = &obj->obj_oss.buf[i];
+        Elf32_Shdr      shdr   = objsec->os_shdr;
+
+        if ((shdr.sh_type == SHT_RELA || shdr.sh_type == SHT_REL) &&
+            shdr.sh_info < obj->obj_oss.len) {
+            relocated[shdr.sh_info] = true;
+
+            if (obj->obj_oss.buf[shdr.sh_info].os_discarded) {
+                objsec->os_discarded = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < obj->obj_oss.len; i++) {
+        ezld_obj_sec_t *objsec = &obj->obj_oss.buf[i];
+
+        if (objsec->os_discarded) {
+            continue;
+        }
+
+        if (objsec->os_shdr.sh_type == SHT_PROGBITS &&
+            (objsec->os_shdr.sh_flags & SHF_COMPRESSED)) {
+            read_compressed_header(objsec);
+        }
+
+        zero_data_to_bss(objsec, relocated[i]);
+        Elf32_Shdr shdr = objsec->os_shdr;
+
+        // Partial links leave deduplication to the final link
+        if (shdr.sh_type == SHT_PROGBITS && (shdr.sh_flags & SHF_MERGE) &&
+            shdr.sh_entsize != 0 && !g_self->i_cfg.cfg_relocatable) {
+            merge_mergeable(objsec);
         } else if (shdr.sh_type == SHT_PROGBITS || shdr.sh_type == SHT_NOBITS) {
             merge_section(objsec);
         }
     }
 
+    free(relocated);
     merge_symtabs(obj);
 }
 
@@ -935,299 +2113,3291 @@ static void read_objects(void) {
 }
 
 /**
- * @brief Writes a segment to disk
+ * @brief Reads the symbol ordering file, if one was given, and assigns a sort
+ * key to every object file section that defines one of the listed symbols. A
+ * section defining multiple listed symbols is placed according to the one that
+ * comes first in the file
+ */
+static void read_symbol_ordering(void) {
+    const char *path = g_self->i_cfg.cfg_symorderpath;
+
+    if (path == NULL) {
+        return;
+    }
+
+    size_t      size  = 0;
+    char       *buf   = ezld_runtime_read_file(path, &size);
+    ezld_htab_t prios = ezld_htab_new();
+    ezld_array(const char *) names = ezld_array_new();
+    ezld_array(bool) used          = ezld_array_new();
+
+    for (char *line = buf; line < buf + size;) {
+        size_t len  = strcspn(line, "\r\n");
+        char  *next = line + len + 1;
+        line[len]   = '\0';
+
+        while (*line == ' ' || *line == '\t') {
+            line++;
+            len--;
+        }
+
+        while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t')) {
+            line[--len] = '\0';
+        }
+
+        size_t prio = names.len;
+        if (len != 0) {
+            if (ezld_htab_put(&prios, line, len, &prio)) {
+                ezld_runtime_message(EZLD_EMSG_WARN,
+                                     "symbol ordering file: symbol '%s' "
+                                     "specified multiple times",
+                                     line);
+            } else {
+                *ezld_array_push(names) = line;
+                *ezld_array_push(used)  = false;
+            }
+        }
+
+        line = next;
+    }
+
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+        for (size_t j = 0; j < obj->obj_ost.ost_syms.len; j++) {
+            ezld_obj_sym_t *sym  = &obj->obj_ost.ost_syms.buf[j];
+            size_t          prio = 0;
+
+            if (!ezld_htab_get(
+                    &prios, sym->osy_name, strlen(sym->osy_name), &prio)) {
+                continue;
+            }
+
+            size_t shndx = sym->osy_esym.st_shndx;
+            if (shndx == SHN_UNDEF || shndx >= obj->obj_oss.len) {
+                continue;
+            }
+
+            // Pieces of mergeable sections are shared, so they cannot be
+            // moved on behalf of a single symbol
+            ezld_obj_sec_t *os = &obj->obj_oss.buf[shndx];
+            if (os->os_mrg == NULL || os->os_mrgsyn != NULL) {
+                continue;
+            }
+
+            used.buf[prio] = true;
+            if (prio < os->os_order) {
+                os->os_order = prio;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < names.len; i++) {
+        if (!used.buf[i]) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "symbol ordering file: no such symbol: %s",
+                                 names.buf[i]);
+        }
+    }
+
+    ezld_htab_free(&prios);
+    ezld_array_free(names);
+    ezld_array_free(used);
+    free(buf);
+}
+
+/**
+ * @brief Finds the object file section in which a symbol referenced by an
+ * object file is defined
  *
- * @param sec the merged section to which the segment is relative
- * @param off the offset in the file where to place the segment's contents
- * @param filename the name of the destination file
- * @param file the actual file
+ * @param obj the object file
+ * @param sym the symbol
  *
- * @return the number of bytes written to the file
+ * @return the section, or `NULL` if the symbol is undefined or defined outside
+ * of any merged section
  */
-static size_t write_segment(ezld_mrg_sec_t *sec,
-                            size_t          off,
-                            const char     *filename,
-                            FILE           *file) {
-    if (ezld_array_first(sec->ms_oss)->os_shdr.sh_type == SHT_NOBITS) {
-        return 0;
+static ezld_obj_sec_t *sym_section(ezld_obj_t *obj, ezld_obj_sym_t *sym) {
+    Elf32_Sym esym = sym->osy_esym;
+
+    if (ELF32_ST_BIND(esym.st_info) != STB_LOCAL ||
+        esym.st_shndx == SHN_UNDEF) {
+        size_t glob_ndx = resolve_sym(NULL, sym, 0, true);
+        if (glob_ndx == EZLD_GLOB_SYM_UNDEF) {
+            return NULL;
+        }
+
+        return g_self->i_globsymtab.buf[glob_ndx - 1].gsy_os;
     }
 
-    size_t written = 0;
-    for (size_t i = 0; i < sec->ms_oss.len; i++) {
-        ezld_obj_sec_t *s = sec->ms_oss.buf[i];
-        read_section_contents(s);
-        ezld_runtime_write_exact_at(
-            s->os_data, s->os_shdr.sh_size, off + written, filename, file);
-        written += s->os_shdr.sh_size;
+    if (esym.st_shndx >= obj->obj_oss.len) {
+        return NULL;
     }
 
-    return written;
+    ezld_obj_sec_t *os = &obj->obj_oss.buf[esym.st_shndx];
+    return (os->os_mrg != NULL) ? os : NULL;
 }
 
 /**
- * @brief Converts an in-memory global string table into a real ELF strtab. It
- * writes the string table on the destination file starting from the file's
- * current cursor position
- *
- * @param sec_name the name of the string table section
- * @param strtab the global string table instance
+ * @param nodes the call graph nodes
+ * @param os the object file section
  *
- * @return the section header describing the string table
+ * @return the index of the node for the section, or `EZLD_CG_NONE`
  */
-static Elf32_Shdr write_strtab(const char         *sec_name,
-                               ezld_glob_strtab_t *strtab) {
-    char zero = '\0';
+static size_t cg_node(ezld_htab_t *nodes, ezld_obj_sec_t *os) {
+    size_t ndx = EZLD_CG_NONE;
 
-    Elf32_Shdr strtab_shdr = {0};
-    strtab_shdr.sh_type    = SHT_STRTAB;
-    strtab_shdr.sh_name    = shstr_from_idx(shstr_add(sec_name)).gs_offset;
-    strtab_shdr.sh_offset  = ftell(g_self->i_out.out_file);
-    strtab_shdr.sh_size    = 1;
+    if (os == NULL || !(os->os_shdr.sh_flags & SHF_EXECINSTR) ||
+        os->os_mrgsyn != NULL) {
+        return EZLD_CG_NONE;
+    }
 
-    ezld_runtime_write_exact(
-        &zero, 1, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
-    for (size_t i = 0; i < strtab->gst_strs.len; i++) {
-        ezld_glob_str_t *str = &strtab->gst_strs.buf[i];
-        ezld_runtime_write_exact((void *)(str->gs_data),
-                                 str->gs_len + 1,
-                                 g_self->i_cfg.cfg_outpath,
-                                 g_self->i_out.out_file);
-        strtab_shdr.sh_size += str->gs_len + 1;
+    (void)ezld_htab_get(nodes, &os, sizeof os, &ndx);
+    return ndx;
+}
+
+/**
+ * @brief Finds the leader of the cluster a node belongs to, compressing the
+ * path along the way
+ */
+static size_t cg_leader(ezld_cg_node_t *nodes, size_t ndx) {
+    while (nodes[ndx].cgn_leader != ndx) {
+        nodes[ndx].cgn_leader = nodes[nodes[ndx].cgn_leader].cgn_leader;
+        ndx                   = nodes[ndx].cgn_leader;
     }
 
-    return endian_shdr(strtab_shdr);
+    return ndx;
 }
 
 /**
- * @brief Writes the output executable to disk (without relocations)
+ * @return the density (weight per byte) of the cluster led by a node
  */
-static void write_exec(void) {
-    Elf32_Ehdr ehdr             = {0};
-    ehdr.e_ident[EI_MAG0]       = ELFMAG0;
-    ehdr.e_ident[EI_MAG1]       = ELFMAG1;
-    ehdr.e_ident[EI_MAG2]       = ELFMAG2;
-    ehdr.e_ident[EI_MAG3]       = ELFMAG3;
-    ehdr.e_ident[EI_CLASS]      = ELFCLASS32;
-    ehdr.e_ident[EI_DATA]       = g_self->i_out.out_endian;
-    ehdr.e_ident[EI_VERSION]    = 1;
-    ehdr.e_ident[EI_OSABI]      = g_self->i_out.out_abi;
-    ehdr.e_ident[EI_ABIVERSION] = g_self->i_out.out_abi_ver;
+static double cg_density(ezld_cg_node_t *node) {
+    size_t size = (node->cgn_size == 0) ? 1 : node->cgn_size;
+    return (double)node->cgn_weight / (double)size;
+}
 
-    ehdr.e_type    = ET_EXEC;
-    ehdr.e_machine = EM_RISCV;
-    ehdr.e_version = EV_CURRENT;
-    ehdr.e_ehsize  = sizeof(Elf32_Ehdr);
+static ezld_cg_node_t *g_cg_sort_nodes = NULL;
 
-    if (g_self->i_osentry == NULL ||
-        g_self->i_osentry->osy_globndx == EZLD_GLOB_SYM_UNDEF) {
-        ezld_runtime_message(EZLD_EMSG_WARN,
-                             "could not resolve entry point symbol '%s', "
-                             "defaulting to base of '.text' section",
-                             g_self->i_cfg.cfg_entrysym);
-        // TODO: actually default to that
-    } else {
-        Elf32_Sym gsym;
-        resolve_sym(&gsym, g_self->i_osentry, EZLD_ENTRY_NAME, false);
-        ehdr.e_entry = gsym.st_value;
+/**
+ * @brief qsort comparator for node indices, sorting by decreasing density and
+ * by index then
+ */
+static int compare_cg_density(const void *a, const void *b) {
+    size_t na = *(const size_t *)a;
+    size_t nb = *(const size_t *)b;
+    double da = cg_density(&g_cg_sort_nodes[na]);
+    double db = cg_density(&g_cg_sort_nodes[nb]);
+
+    if (da != db) {
+        return (da > db) ? -1 : 1;
     }
 
-    // Header will be added later
-    ezld_runtime_seek(
-        sizeof(Elf32_Ehdr), g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+    return (na > nb) - (na < nb);
+}
 
-    ehdr.e_phoff     = sizeof(Elf32_Ehdr);
-    ehdr.e_phentsize = sizeof(Elf32_Phdr);
-    ehdr.e_shnum     = 3; // NULL, ..., .strtab, .shstrtab
-    ehdr.e_shentsize = sizeof(Elf32_Shdr);
-    ezld_array(struct {
-        Elf32_Phdr      phdr;
-        ezld_mrg_sec_t *sec;
-    }) tmp_phdrs     = ezld_array_new();
-    size_t phdrs_end = ehdr.e_phoff;
+/**
+ * @brief qsort comparator for call graph edges, sorting by callee and caller
+ */
+static int compare_cg_edges(const void *a, const void *b) {
+    const ezld_cg_edge_t *ea = a;
+    const ezld_cg_edge_t *eb = b;
 
-    for (size_t i = 0; i < g_self->i_mss.len; i++) {
-        ezld_mrg_sec_t *mrg = &g_self->i_mss.buf[i];
+    if (ea->cge_to != eb->cge_to) {
+        return (ea->cge_to < eb->cge_to) ? -1 : 1;
+    }
 
-        if (!ezld_array_is_empty(mrg->ms_oss) &&
-            (ezld_array_first(mrg->ms_oss)->os_shdr.sh_flags & SHF_ALLOC)) {
-            Elf32_Shdr base = ezld_array_first(mrg->ms_oss)->os_shdr;
-            ehdr.e_phnum++;
-            Elf32_Phdr phdr = {0};
-            phdr.p_type     = PT_LOAD;
-            phdr.p_align    = g_self->i_cfg.cfg_segalign;
-            phdr.p_vaddr    = mrg->ms_vaddr;
-            phdr.p_paddr    = mrg->ms_vaddr;
-            phdr.p_memsz    = mrg->ms_memsz;
-            phdr.p_flags    = PF_R;
-            size_t sh_flags = ezld_array_first(mrg->ms_oss)->os_shdr.sh_flags;
+    return (ea->cge_from > eb->cge_from) - (ea->cge_from < eb->cge_from);
+}
 
-            if (base.sh_type != SHT_NOBITS) {
-                phdr.p_filesz = mrg->ms_memsz;
-            }
+/**
+ * @brief Collects call graph edges from the R_RISCV_JAL and R_RISCV_CALL
+ * relocations of all object files, giving each call site a weight of 1
+ */
+static void cg_static_edges(ezld_htab_t *nodes, ezld_cg_edges_t *edges) {
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
 
-            if (sh_flags & SHF_WRITE) {
-                phdr.p_flags |= PF_W;
-            }
+        for (size_t j = 0; j < obj->obj_oss.len; j++) {
+            ezld_obj_sec_t *rela = &obj->obj_oss.buf[j];
 
-            if (sh_flags & SHF_EXECINSTR) {
-                phdr.p_flags |= PF_X;
+            if (rela->os_shdr.sh_type != SHT_RELA || rela->os_discarded ||
+                rela->os_shdr.sh_info >= obj->obj_oss.len ||
+                rela->os_shdr.sh_entsize != sizeof(Elf32_Rela)) {
+                continue;
             }
 
-            (void)ezld_array_push(tmp_phdrs);
-            ezld_array_last(tmp_phdrs).phdr = phdr;
-            ezld_array_last(tmp_phdrs).sec  = mrg;
-            phdrs_end += sizeof(Elf32_Phdr);
-        }
-    }
+            ezld_obj_sec_t *target = &obj->obj_oss.buf[rela->os_shdr.sh_info];
+            size_t          from   = cg_node(nodes, target);
+            if (from == EZLD_CG_NONE) {
+                continue;
+            }
 
-    size_t seg_off = phdrs_end;
-    for (size_t i = 0; i < tmp_phdrs.len; i++) {
-        Elf32_Phdr      phdr = tmp_phdrs.buf[i].phdr;
-        ezld_mrg_sec_t *sec  = tmp_phdrs.buf[i].sec;
-        seg_off += phdr.p_align - (seg_off % phdr.p_align);
-        phdr.p_offset   = seg_off;
-        sec->ms_fileoff = seg_off;
-        phdr            = endian_phdr(phdr);
-        ezld_runtime_write_exact(&phdr,
-                                 sizeof(Elf32_Phdr),
-                                 g_self->i_cfg.cfg_outpath,
-                                 g_self->i_out.out_file);
-        (void)write_segment(
-            sec, seg_off, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
-        seg_off += phdr.p_filesz;
-    }
+            read_section_contents(rela);
+            Elf32_Rela *relas = (Elf32_Rela *)rela->os_data;
 
-    ezld_runtime_seek(
-        seg_off, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+            for (size_t k = 0; k < rela->os_elems; k++) {
+                size_t type    = ELF32_R_TYPE(relas[k].r_info);
+                size_t sym_idx = ELF32_R_SYM(relas[k].r_info);
 
-    Elf32_Shdr strtab_shdr   = write_strtab(".strtab", &g_self->i_globstrtab);
-    Elf32_Shdr shstrtab_shdr = write_strtab(".shstrtab", &g_self->i_shstrtab);
+                if ((type != R_RISCV_JAL && type != R_RISCV_CALL &&
+                     type != R_RISCV_CALL_PLT) ||
+                    sym_idx >= obj->obj_ost.ost_syms.len) {
+                    continue;
+                }
 
-    ehdr.e_shoff = ftell(g_self->i_out.out_file);
+                ezld_obj_sym_t *sym = &obj->obj_ost.ost_syms.buf[sym_idx];
+                size_t          to  = cg_node(nodes, sym_section(obj, sym));
 
-    Elf32_Shdr null_shdr = {0};
+                if (to != EZLD_CG_NONE && to != from) {
+                    *ezld_array_push(*edges) = (ezld_cg_edge_t){
+                        .cge_from = from, .cge_to = to, .cge_weight = 1};
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Collects call graph edges from a profile file. Each line has the form
+ * `<caller> <callee> <count>`, where caller and callee are symbol names
+ */
+static void cg_profile_edges(ezld_htab_t *nodes, ezld_cg_edges_t *edges) {
+    const char *path = g_self->i_cfg.cfg_cgprofile;
+    size_t      size = 0;
+    char       *buf  = ezld_runtime_read_file(path, &size);
+    ezld_htab_t syms = ezld_htab_new();
+
+    // Map every defined symbol name to the node of its section. The first
+    // definition wins if a (local) name is defined multiple times
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+        for (size_t j = 0; j < obj->obj_ost.ost_syms.len; j++) {
+            ezld_obj_sym_t *sym = &obj->obj_ost.ost_syms.buf[j];
+
+            if (sym->osy_esym.st_shndx == SHN_UNDEF ||
+                ELF32_ST_TYPE(sym->osy_esym.st_info) == STT_SECTION ||
+                ELF32_ST_TYPE(sym->osy_esym.st_info) == STT_FILE) {
+                continue;
+            }
+
+            size_t node = cg_node(nodes, sym_section(obj, sym));
+            if (node != EZLD_CG_NONE) {
+                (void)ezld_htab_put(
+                    &syms, sym->osy_name, strlen(sym->osy_name), &node);
+            }
+        }
+    }
+
+    size_t line_num = 1;
+    for (char *line = buf; line < buf + size; line_num++) {
+        size_t len  = strcspn(line, "\r\n");
+        char  *next = line + len + 1;
+        line[len]   = '\0';
+
+        char caller[256], callee[256];
+        unsigned long long count = 0;
+        int                n     = sscanf(
+            line, "%255s %255s %llu", caller, callee, &count);
+
+        if (n == 3) {
+            size_t from = EZLD_CG_NONE, to = EZLD_CG_NONE;
+            (void)ezld_htab_get(&syms, caller, strlen(caller), &from);
+            (void)ezld_htab_get(&syms, callee, strlen(callee), &to);
+
+            if (from != EZLD_CG_NONE && to != EZLD_CG_NONE && from != to) {
+                *ezld_array_push(*edges) = (ezld_cg_edge_t){
+                    .cge_from = from, .cge_to = to, .cge_weight = count};
+            }
+        } else if (n > 0) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "%s:%zu: expected '<caller> <callee> "
+                                 "<count>', ignoring line",
+                                 path,
+                                 line_num);
+        }
+
+        line = next;
+    }
+
+    ezld_htab_free(&syms);
+    free(buf);
+}
+
+/**
+ * @brief Orders executable sections with the C3 heuristic (Ottoni and Maher,
+ * "Optimizing Function Placement for Large-Scale Data-Center Applications").
+ * Each section starts in its own cluster. Going through sections from the
+ * densest (most calls per byte) to the sparsest, the cluster of a section is
+ * appended to the cluster of its most frequent caller, unless that makes the
+ * result too large or too sparse. Clusters are then laid out by decreasing
+ * density, ties (such as sections that are never called) keeping input order
+ */
+static void sort_call_graph(void) {
+    if (!g_self->i_cfg.cfg_cgsort && g_self->i_cfg.cfg_cgprofile == NULL) {
+        return;
+    }
+
+    if (g_self->i_cfg.cfg_symorderpath != NULL) {
+        ezld_runtime_message(EZLD_EMSG_WARN,
+                             "--symbol-ordering-file takes precedence over "
+                             "call graph sorting, which will not be done");
+        return;
+    }
+
+    // Nodes are counted first so that the node array never moves, since the
+    // hash table keys point into it
+    size_t num_nodes = 0;
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+        for (size_t j = 0; j < mrg->ms_oss.len; j++) {
+            if (mrg->ms_oss.buf[j]->os_shdr.sh_flags & SHF_EXECINSTR) {
+                num_nodes++;
+            }
+        }
+    }
+
+    if (num_nodes == 0) {
+        return;
+    }
+
+    ezld_cg_node_t *nodes    = ezld_runtime_alloc(sizeof(ezld_cg_node_t),
+                                               num_nodes);
+    ezld_htab_t     node_map = ezld_htab_new();
+    ezld_cg_edges_t edges    = ezld_array_new();
+
+    size_t n = 0;
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+        for (size_t j = 0; j < mrg->ms_oss.len; j++) {
+            ezld_obj_sec_t *os = mrg->ms_oss.buf[j];
+
+            if (!(os->os_shdr.sh_flags & SHF_EXECINSTR)) {
+                continue;
+            }
+
+            nodes[n] = (ezld_cg_node_t){.cgn_os         = os,
+                                        .cgn_leader     = n,
+                                        .cgn_next       = n,
+                                        .cgn_prev       = n,
+                                        .cgn_initweight = 0,
+                                        .cgn_weight     = 0,
+                                        .cgn_size       = os->os_shdr.sh_size,
+                                        .cgn_bestpred   = EZLD_CG_NONE,
+                                        .cgn_bestweight = 0};
+            size_t ndx = n;
+            (void)ezld_htab_put(
+                &node_map, &nodes[n].cgn_os, sizeof nodes[n].cgn_os, &ndx);
+            n++;
+        }
+    }
+
+    if (g_self->i_cfg.cfg_cgprofile != NULL) {
+        cg_profile_edges(&node_map, &edges);
+    } else {
+        cg_static_edges(&node_map, &edges);
+    }
+
+    // Sum the weights of parallel edges and find the best caller of each node
+    if (edges.len > 1) {
+        qsort(edges.buf, edges.len, sizeof(ezld_cg_edge_t), compare_cg_edges);
+    }
+
+    for (size_t i = 0; i < edges.len;) {
+        ezld_cg_edge_t e = edges.buf[i++];
+
+        while (i < edges.len && edges.buf[i].cge_from == e.cge_from &&
+               edges.buf[i].cge_to == e.cge_to) {
+            e.cge_weight += edges.buf[i++].cge_weight;
+        }
+
+        ezld_cg_node_t *to = &nodes[e.cge_to];
+        to->cgn_initweight += e.cge_weight;
+        to->cgn_weight += e.cge_weight;
+
+        if (e.cge_weight > to->cgn_bestweight) {
+            to->cgn_bestpred   = e.cge_from;
+            to->cgn_bestweight = e.cge_weight;
+        }
+    }
+
+    size_t *sorted = ezld_runtime_alloc(sizeof(size_t), num_nodes);
+    for (size_t i = 0; i < num_nodes; i++) {
+        sorted[i] = i;
+    }
+
+    g_cg_sort_nodes = nodes;
+    qsort(sorted, num_nodes, sizeof(size_t), compare_cg_density);
+
+    for (size_t i = 0; i < num_nodes; i++) {
+        size_t          ndx  = sorted[i];
+        ezld_cg_node_t *node = &nodes[ndx];
+
+        // Ignore callers that account for a small share of the calls, since
+        // merging with them would not buy much
+        if (node->cgn_bestpred == EZLD_CG_NONE ||
+            node->cgn_bestweight * 10 <= node->cgn_initweight) {
+            continue;
+        }
+
+        size_t pred_ndx = cg_leader(nodes, node->cgn_bestpred);
+        if (pred_ndx == ndx) {
+            continue;
+        }
+
+        ezld_cg_node_t *pred = &nodes[pred_ndx];
+        if (pred->cgn_size + node->cgn_size > EZLD_CG_CLUSTER_LIMIT) {
+            continue;
+        }
+
+        ezld_cg_node_t merged = *pred;
+        merged.cgn_size += node->cgn_size;
+        merged.cgn_weight += node->cgn_weight;
+        if (cg_density(&merged) * EZLD_CG_MAX_DENSITY_DROP <
+            cg_density(pred)) {
+            continue;
+        }
+
+        // Append this cluster at the end of the caller's cluster
+        size_t pred_tail = pred->cgn_prev;
+        size_t node_tail = node->cgn_prev;
+        nodes[pred_tail].cgn_next = ndx;
+        node->cgn_prev            = pred_tail;
+        nodes[node_tail].cgn_next = pred_ndx;
+        pred->cgn_prev            = node_tail;
+        pred->cgn_size            = merged.cgn_size;
+        pred->cgn_weight          = merged.cgn_weight;
+        node->cgn_leader          = pred_ndx;
+    }
+
+    size_t num_clusters = 0;
+    for (size_t i = 0; i < num_nodes; i++) {
+        if (cg_leader(nodes, i) == i) {
+            sorted[num_clusters++] = i;
+        }
+    }
+
+    qsort(sorted, num_clusters, sizeof(size_t), compare_cg_density);
+
+    size_t order = 0;
+    for (size_t i = 0; i < num_clusters; i++) {
+        size_t ndx = sorted[i];
+        do {
+            nodes[ndx].cgn_os->os_order = order++;
+            ndx                         = nodes[ndx].cgn_next;
+        } while (ndx != sorted[i]);
+    }
+
+    g_cg_sort_nodes = NULL;
+    free(sorted);
+    free(nodes);
+    ezld_htab_free(&node_map);
+    ezld_array_free(edges);
+}
+
+/**
+ * @brief Writes a segment to disk
+ *
+ * @param sec the merged section to which the segment is relative
+ * @param off the offset in the file where to place the segment's contents
+ * @param filename the name of the destination file
+ * @param file the actual file
+ *
+ * @return the number of bytes written to the file
+ */
+static size_t write_segment(ezld_mrg_sec_t *sec,
+                            size_t          off,
+                            const char     *filename,
+                            FILE           *file) {
+    if (sec->ms_shdr.sh_type == SHT_NOBITS) {
+        return 0;
+    }
+
+    size_t written = 0;
+    for (size_t i = 0; i < sec->ms_oss.len; i++) {
+        ezld_obj_sec_t *s = sec->ms_oss.buf[i];
+        read_section_contents(s);
+        ezld_runtime_write_exact_at(
+            s->os_data, s->os_shdr.sh_size, off + s->os_transl, filename, file);
+        written += s->os_shdr.sh_size;
+
+        if (s->os_island != NULL) {
+            ezld_obj_sec_t *island = s->os_island;
+            ezld_runtime_write_exact_at(island->os_data,
+                                        island->os_shdr.sh_size,
+                                        off + island->os_transl,
+                                        filename,
+                                        file);
+            written += island->os_shdr.sh_size;
+        }
+    }
+
+    return written;
+}
+
+/**
+ * @brief Converts an in-memory global string table into a real ELF strtab. It
+ * writes the string table on the destination file starting from the file's
+ * current cursor position
+ *
+ * @param sec_name the name of the string table section
+ * @param strtab the global string table instance
+ *
+ * @return the section header describing the string table
+ */
+static Elf32_Shdr write_strtab(const char         *sec_name,
+                               ezld_glob_strtab_t *strtab) {
+    char zero = '\0';
+
+    Elf32_Shdr strtab_shdr = {0};
+    strtab_shdr.sh_type    = SHT_STRTAB;
+    strtab_shdr.sh_name    = shstr_from_idx(shstr_add(sec_name)).gs_offset;
+    strtab_shdr.sh_offset  = ftell(g_self->i_out.out_file);
+    strtab_shdr.sh_size    = 1;
+
+    ezld_runtime_write_exact(
+        &zero, 1, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+    for (size_t i = 0; i < strtab->gst_strs.len; i++) {
+        ezld_glob_str_t *str = &strtab->gst_strs.buf[i];
+        ezld_runtime_write_exact((void *)(str->gs_data),
+                                 str->gs_len + 1,
+                                 g_self->i_cfg.cfg_outpath,
+                                 g_self->i_out.out_file);
+        strtab_shdr.sh_size += str->gs_len + 1;
+    }
+
+    return endian_shdr(strtab_shdr);
+}
+
+/**
+ * @brief Assigns section header indices to all non-empty merged sections, in
+ * the order in which they are written. Index 0 is the null section
+ *
+ * @return the number of merged sections that are written
+ */
+static size_t number_sections(void) {
+    size_t num = 0;
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+        mrg->ms_outndx      = 0;
+
+        if (!ezld_array_is_empty(mrg->ms_oss)) {
+            mrg->ms_outndx = ++num;
+        }
+    }
+
+    return num;
+}
+
+/**
+ * @brief Appends a symbol to an output symbol table
+ *
+ * @param st the output symbol table
+ * @param name the name of the symbol, or `NULL` if it has none
+ * @param sym the symbol table entry, whose `st_name` is ignored
+ *
+ * @return the index of the symbol in the table
+ */
+static size_t out_sym_add(ezld_out_symtab_t *st,
+                          const char        *name,
+                          Elf32_Sym          sym) {
+    sym.st_name = 0;
+
+    if (name != NULL && *name != '\0') {
+        sym.st_name = st->ot_strs.len;
+        for (size_t i = 0; i <= strlen(name); i++) {
+            *ezld_array_push(st->ot_strs) = name[i];
+        }
+    }
+
+    *ezld_array_push(st->ot_syms) = sym;
+    return st->ot_syms.len - 1;
+}
+
+/**
+ * @param os the object file section in which the symbol is defined
+ * @param off the offset of the symbol in `os`
+ * @param relocatable `true` if the value is to be relative to the merged
+ * section, `false` if it is to be a virtual address
+ *
+ * @return the value of the symbol in the output file
+ */
+static uint32_t out_sym_value(ezld_obj_sec_t *os,
+                              size_t          off,
+                              bool            relocatable) {
+    uint32_t value = translate_off(os, off);
+    return relocatable ? value : os->os_mrg->ms_vaddr + value;
+}
+
+/**
+ * @brief qsort comparator for output symbol table entries, sorting by address
+ * first and by index before sorting then
+ */
+static int compare_sort_syms(const void *a, const void *b) {
+    const ezld_sort_sym_t *sa = a;
+    const ezld_sort_sym_t *sb = b;
+
+    if (sa->ss_sym.st_value != sb->ss_sym.st_value) {
+        return (sa->ss_sym.st_value < sb->ss_sym.st_value) ? -1 : 1;
+    }
+
+    return (sa->ss_old > sb->ss_old) - (sa->ss_old < sb->ss_old);
+}
+
+/**
+ * @brief Sorts a range of entries of an output symbol table by address
+ *
+ * @param st the output symbol table
+ * @param start the index of the first entry to be sorted
+ * @param end the index after the last entry to be sorted
+ * @param remap where the index of each entry after sorting is stored, indexed
+ * by the index before sorting
+ */
+static void sort_out_syms(ezld_out_symtab_t *st,
+                          size_t             start,
+                          size_t             end,
+                          size_t            *remap) {
+    if (end - start < 2) {
+        return;
+    }
+
+    ezld_sort_sym_t *tmp =
+        ezld_runtime_alloc(end - start, sizeof(ezld_sort_sym_t));
+
+    for (size_t i = start; i < end; i++) {
+        tmp[i - start].ss_sym = st->ot_syms.buf[i];
+        tmp[i - start].ss_old = i;
+    }
+
+    qsort(tmp, end - start, sizeof(ezld_sort_sym_t), compare_sort_syms);
+
+    for (size_t i = start; i < end; i++) {
+        st->ot_syms.buf[i]         = tmp[i - start].ss_sym;
+        remap[tmp[i - start].ss_old] = i;
+    }
+
+    free(tmp);
+}
+
+/**
+ * @brief Builds the symbol table of the output file: a section symbol for each
+ * merged section, the local symbols of all object files, the global symbols,
+ * and the symbols that are referenced but not defined. The index of each
+ * object file symbol in the table is stored in `osy_outndx`.
+ * `number_sections` must have been called before. In executables, globals and
+ * the locals of each file are sorted by address, and locals are left out if
+ * so requested unless relocations are kept
+ *
+ * @param st the output symbol table, which is initialized by this function
+ * @param relocatable `true` if values are to be relative to the merged
+ * sections, `false` if they are to be virtual addresses
+ */
+static void build_symtab(ezld_out_symtab_t *st, bool relocatable) {
+    ezld_array_init(st->ot_syms);
+    ezld_array_init(st->ot_strs);
+    *ezld_array_push(st->ot_strs) = '\0';
+    (void)out_sym_add(st, NULL, (Elf32_Sym){0});
+
+    bool keep_relocs = relocatable || g_self->i_cfg.cfg_emitrelocs;
+    bool keep_locals = keep_relocs || !g_self->i_cfg.cfg_discardlocals;
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (mrg->ms_outndx != 0) {
+            Elf32_Sym sym  = {0};
+            sym.st_info    = ELF32_ST_INFO(STB_LOCAL, STT_SECTION);
+            sym.st_value   = relocatable ? 0 : mrg->ms_vaddr;
+            sym.st_shndx   = mrg->ms_outndx;
+            mrg->ms_symndx = out_sym_add(st, NULL, sym);
+        }
+    }
+
+    size_t first_local = st->ot_syms.len;
+
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+        for (size_t j = 1; j < obj->obj_ost.ost_syms.len; j++) {
+            ezld_obj_sym_t *osym = &obj->obj_ost.ost_syms.buf[j];
+            Elf32_Sym       sym  = osym->osy_esym;
+            osym->osy_outndx     = 0;
+
+            // Section symbols are replaced by those of the merged sections
+            if (ELF32_ST_BIND(sym.st_info) != STB_LOCAL ||
+                ELF32_ST_TYPE(sym.st_info) == STT_SECTION ||
+                sym.st_shndx == SHN_UNDEF || !keep_locals) {
+                continue;
+            }
+
+            // Assembler temporaries are only useful to relocations
+            if (!keep_relocs && strncmp(osym->osy_name, ".L", 2) == 0) {
+                continue;
+            }
+
+            // Absolute symbols (including file names) are kept as they are
+            if (sym.st_shndx < SHN_LORESERVE) {
+                ezld_obj_sec_t *os = sym_section(obj, osym);
+
+                if (os == NULL) {
+                    continue;
+                }
+
+                sym.st_value = out_sym_value(os, sym.st_value, relocatable);
+                sym.st_shndx = os->os_mrg->ms_outndx;
+            }
+
+            osym->osy_outndx = out_sym_add(st, osym->osy_name, sym);
+        }
+    }
+
+    st->ot_firstglob = st->ot_syms.len;
+
+    for (size_t i = 0; i < g_self->i_globsymtab.len; i++) {
+        ezld_glob_sym_t *gsym = &g_self->i_globsymtab.buf[i];
+        Elf32_Sym        sym  = gsym->gsy_esym;
+        sym.st_value = out_sym_value(gsym->gsy_os, gsym->gsy_off, relocatable);
+        sym.st_shndx = gsym->gsy_os->os_mrg->ms_outndx;
+        (void)out_sym_add(st, globstr_from_idx(sym.st_name).gs_data, sym);
+    }
+
+    // Undefined symbols are added once for all references, and are weak only
+    // if all references are weak
+    ezld_htab_t undefs = ezld_htab_new();
+
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+        for (size_t j = 1; j < obj->obj_ost.ost_syms.len; j++) {
+            ezld_obj_sym_t *osym = &obj->obj_ost.ost_syms.buf[j];
+            Elf32_Sym       esym = osym->osy_esym;
+
+            if (ELF32_ST_BIND(esym.st_info) == STB_LOCAL) {
+                continue;
+            }
+
+            size_t glob_ndx = resolve_sym(NULL, osym, 0, true);
+            if (glob_ndx != EZLD_GLOB_SYM_UNDEF) {
+                osym->osy_outndx = st->ot_firstglob + glob_ndx - 1;
+                continue;
+            }
+
+            size_t ndx = st->ot_syms.len;
+            if (!ezld_htab_put(&undefs,
+                               osym->osy_name,
+                               strlen(osym->osy_name),
+                               &ndx)) {
+                Elf32_Sym sym = {0};
+                sym.st_info   = esym.st_info;
+                sym.st_other  = esym.st_other;
+                sym.st_shndx  = SHN_UNDEF;
+                (void)out_sym_add(st, osym->osy_name, sym);
+            } else if (ELF32_ST_BIND(esym.st_info) == STB_GLOBAL) {
+                Elf32_Sym *sym = &st->ot_syms.buf[ndx];
+                sym->st_info =
+                    ELF32_ST_INFO(STB_GLOBAL, ELF32_ST_TYPE(sym->st_info));
+            }
+
+            osym->osy_outndx = ndx;
+        }
+    }
+
+    ezld_htab_free(&undefs);
+
+    // Symbolizers expect symbols to be sorted by address, which changes the
+    // indices recorded so far
+    if (!relocatable) {
+        size_t *remap = ezld_runtime_alloc(st->ot_syms.len, sizeof(size_t));
+        for (size_t i = 0; i < st->ot_syms.len; i++) {
+            remap[i] = i;
+        }
+
+        // Locals belong to the file named by the STT_FILE entry before them,
+        // so each file's locals are sorted on their own, after its name
+        size_t run = first_local;
+        for (size_t i = first_local; i < st->ot_firstglob; i++) {
+            if (ELF32_ST_TYPE(st->ot_syms.buf[i].st_info) == STT_FILE) {
+                sort_out_syms(st, run, i, remap);
+                run = i + 1;
+            }
+        }
+
+        sort_out_syms(st, run, st->ot_firstglob, remap);
+        sort_out_syms(st,
+                      st->ot_firstglob,
+                      st->ot_firstglob + g_self->i_globsymtab.len,
+                      remap);
+
+        for (size_t i = 0; i < g_self->i_objs.len; i++) {
+            ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+            for (size_t j = 0; j < obj->obj_ost.ost_syms.len; j++) {
+                ezld_obj_sym_t *osym = &obj->obj_ost.ost_syms.buf[j];
+                osym->osy_outndx     = remap[osym->osy_outndx];
+            }
+        }
+
+        free(remap);
+    }
+}
+
+/**
+ * @brief Rewrites the relocations of all object files so that they apply to
+ * the merged sections and refer to the symbols of the table built by
+ * `build_symtab`, which must have been called before. The rewritten
+ * relocations are stored in the `ms_relas` field of the merged sections
+ *
+ * @param relocatable `true` if offsets are to be relative to the merged
+ * sections, `false` if they are to be virtual addresses
+ */
+static void collect_relocs(bool relocatable) {
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+        for (size_t j = 0; j < obj->obj_oss.len; j++) {
+            ezld_obj_sec_t *rela = &obj->obj_oss.buf[j];
+
+            if (rela->os_shdr.sh_type != SHT_RELA || rela->os_discarded ||
+                rela->os_shdr.sh_info >= obj->obj_oss.len) {
+                continue;
+            }
+
+            ezld_obj_sec_t *target = &obj->obj_oss.buf[rela->os_shdr.sh_info];
+            if (target->os_mrg == NULL || target->os_mrgsyn != NULL) {
+                continue;
+            }
+
+            read_section_contents(rela);
+            Elf32_Rela *relas = (Elf32_Rela *)rela->os_data;
+            size_t      num   = rela->os_shdr.sh_size / sizeof(Elf32_Rela);
+
+            for (size_t k = 0; k < num; k++) {
+                Elf32_Rela entry   = endian_rela(relas[k]);
+                size_t     sym_idx = ELF32_R_SYM(entry.r_info);
+
+                if (sym_idx >= obj->obj_ost.ost_syms.len) {
+                    ezld_runtime_message(EZLD_EMSG_ERR,
+                                         "relocation in '%s' references "
+                                         "invalid symbol number 0x%zx",
+                                         obj->obj_filepath,
+                                         sym_idx);
+                    continue;
+                }
+
+                ezld_obj_sym_t *sym    = &obj->obj_ost.ost_syms.buf[sym_idx];
+                Elf32_Sym       esym   = sym->osy_esym;
+                size_t          outsym = sym->osy_outndx;
+                int32_t         addend = entry.r_addend;
+
+                // References through section symbols become references
+                // through the symbol of the merged section, so the position of
+                // the object file section goes into the addend
+                if (sym_idx != 0 && ELF32_ST_BIND(esym.st_info) == STB_LOCAL &&
+                    ELF32_ST_TYPE(esym.st_info) == STT_SECTION) {
+                    ezld_obj_sec_t *os = sym_section(obj, sym);
+
+                    if (os == NULL) {
+                        ezld_runtime_message(EZLD_EMSG_WARN,
+                                             "relocation in '%s' references "
+                                             "a section that is not part of "
+                                             "the output, ignoring",
+                                             obj->obj_filepath);
+                        continue;
+                    }
+
+                    outsym = os->os_mrg->ms_symndx;
+                    addend = translate_off(os, esym.st_value + addend);
+                } else if (sym_idx != 0 && outsym == 0) {
+                    ezld_runtime_message(EZLD_EMSG_WARN,
+                                         "relocation in '%s' references "
+                                         "symbol '%s', which is not part of "
+                                         "the output, ignoring",
+                                         obj->obj_filepath,
+                                         sym->osy_name);
+                    continue;
+                }
+
+                Elf32_Rela out = {0};
+                out.r_offset =
+                    out_sym_value(target, entry.r_offset, relocatable);
+                out.r_info = ELF32_R_INFO(outsym, ELF32_R_TYPE(entry.r_info));
+                out.r_addend                               = addend;
+                *ezld_array_push(target->os_mrg->ms_relas) = out;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Writes a symbol table built by `build_symtab` and its string table to
+ * the output file
+ *
+ * @param st the output symbol table
+ * @param off the offset in the output file where to write the symbol table
+ * @param strtab_shdr where the section header of the string table is stored
+ * @param strtab_ndx the index of the section header of the string table
+ *
+ * @return the section header of the symbol table
+ */
+static Elf32_Shdr write_symtab(ezld_out_symtab_t *st,
+                               size_t             off,
+                               Elf32_Shdr        *strtab_shdr,
+                               size_t             strtab_ndx) {
+    Elf32_Shdr shdr   = {0};
+    shdr.sh_name      = shstr_from_idx(shstr_add(".symtab")).gs_offset;
+    shdr.sh_type      = SHT_SYMTAB;
+    shdr.sh_offset    = align_up(off, 4);
+    shdr.sh_size      = st->ot_syms.len * sizeof(Elf32_Sym);
+    shdr.sh_link      = strtab_ndx;
+    shdr.sh_info      = st->ot_firstglob;
+    shdr.sh_addralign = 4;
+    shdr.sh_entsize   = sizeof(Elf32_Sym);
+
+    for (size_t i = 0; i < st->ot_syms.len; i++) {
+        Elf32_Sym sym = endian_sym(st->ot_syms.buf[i]);
+        ezld_runtime_write_exact_at(&sym,
+                                    sizeof(Elf32_Sym),
+                                    shdr.sh_offset + i * sizeof(Elf32_Sym),
+                                    g_self->i_cfg.cfg_outpath,
+                                    g_self->i_out.out_file);
+    }
+
+    *strtab_shdr              = (Elf32_Shdr){0};
+    strtab_shdr->sh_name      = shstr_from_idx(shstr_add(".strtab")).gs_offset;
+    strtab_shdr->sh_type      = SHT_STRTAB;
+    strtab_shdr->sh_offset    = shdr.sh_offset + shdr.sh_size;
+    strtab_shdr->sh_size      = st->ot_strs.len;
+    strtab_shdr->sh_addralign = 1;
+    ezld_runtime_write_exact_at(st->ot_strs.buf,
+                                st->ot_strs.len,
+                                strtab_shdr->sh_offset,
+                                g_self->i_cfg.cfg_outpath,
+                                g_self->i_out.out_file);
+    return shdr;
+}
+
+/**
+ * @brief Writes the relocations collected for a merged section to the output
+ * file, in a section named after the merged section
+ *
+ * @param mrg the merged section
+ * @param off the offset in the output file where to write the relocations
+ * @param symtab_ndx the index of the section header of the symbol table
+ *
+ * @return the section header of the relocation section
+ */
+static Elf32_Shdr write_relas(ezld_mrg_sec_t *mrg,
+                              size_t          off,
+                              size_t          symtab_ndx) {
+    const char *sec_name = shstr_from_idx(mrg->ms_name).gs_data;
+    char       *name     = ezld_runtime_alloc(1, strlen(sec_name) + 6);
+    strcpy(name, ".rela");
+    strcat(name, sec_name);
+    *ezld_array_push(g_self->i_ownedstrs) = name;
+
+    Elf32_Shdr shdr   = {0};
+    shdr.sh_name      = shstr_from_idx(shstr_add(name)).gs_offset;
+    shdr.sh_type      = SHT_RELA;
+    shdr.sh_flags     = SHF_INFO_LINK;
+    shdr.sh_offset    = align_up(off, 4);
+    shdr.sh_size      = mrg->ms_relas.len * sizeof(Elf32_Rela);
+    shdr.sh_link      = symtab_ndx;
+    shdr.sh_info      = mrg->ms_outndx;
+    shdr.sh_addralign = 4;
+    shdr.sh_entsize   = sizeof(Elf32_Rela);
+
+    for (size_t i = 0; i < mrg->ms_relas.len; i++) {
+        Elf32_Rela rela = endian_rela(mrg->ms_relas.buf[i]);
+        ezld_runtime_write_exact_at(&rela,
+                                    sizeof(Elf32_Rela),
+                                    shdr.sh_offset + i * sizeof(Elf32_Rela),
+                                    g_self->i_cfg.cfg_outpath,
+                                    g_self->i_out.out_file);
+    }
+
+    return shdr;
+}
+
+/**
+ * @brief Writes a symbol table built by `build_symtab`, its string table, and
+ * the relocations collected by `collect_relocs` to the output file
+ *
+ * @param st the output symbol table
+ * @param off the offset in the output file where to start writing
+ * @param symtab_ndx the index of the section header of the symbol table. The
+ * string table and the relocation sections follow it
+ * @param shdrs where the section headers are appended, in the byte order of
+ * the output file
+ *
+ * @return the offset in the output file after the last section written
+ */
+static size_t write_symtab_relas(ezld_out_symtab_t *st,
+                                 size_t             off,
+                                 size_t             symtab_ndx,
+                                 ezld_shdrs_t      *shdrs) {
+    Elf32_Shdr strtab_shdr;
+    Elf32_Shdr symtab_shdr =
+        write_symtab(st, off, &strtab_shdr, symtab_ndx + 1);
+    *ezld_array_push(*shdrs) = endian_shdr(symtab_shdr);
+    *ezld_array_push(*shdrs) = endian_shdr(strtab_shdr);
+    off = strtab_shdr.sh_offset + strtab_shdr.sh_size;
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (!ezld_array_is_empty(mrg->ms_relas)) {
+            Elf32_Shdr shdr          = write_relas(mrg, off, symtab_ndx);
+            off                      = shdr.sh_offset + shdr.sh_size;
+            *ezld_array_push(*shdrs) = endian_shdr(shdr);
+        }
+    }
+
+    return off;
+}
+
+/**
+ * @param type the type of the output file
+ *
+ * @return an ELF header for the output file, with all fields that do not depend
+ * on its contents set
+ */
+static Elf32_Ehdr new_ehdr(Elf32_Half type) {
+    Elf32_Ehdr ehdr             = {0};
+    ehdr.e_ident[EI_MAG0]       = ELFMAG0;
+    ehdr.e_ident[EI_MAG1]       = ELFMAG1;
+    ehdr.e_ident[EI_MAG2]       = ELFMAG2;
+    ehdr.e_ident[EI_MAG3]       = ELFMAG3;
+    ehdr.e_ident[EI_CLASS]      = ELFCLASS32;
+    ehdr.e_ident[EI_DATA]       = g_self->i_out.out_endian;
+    ehdr.e_ident[EI_VERSION]    = 1;
+    ehdr.e_ident[EI_OSABI]      = g_self->i_out.out_abi;
+    ehdr.e_ident[EI_ABIVERSION] = g_self->i_out.out_abi_ver;
+
+    ehdr.e_type      = type;
+    ehdr.e_machine   = EM_RISCV;
+    ehdr.e_version   = EV_CURRENT;
+    ehdr.e_ehsize    = sizeof(Elf32_Ehdr);
+    ehdr.e_shentsize = sizeof(Elf32_Shdr);
+    return ehdr;
+}
+
+/**
+ * @return the address of the entry point symbol, or that of the unpacking stub
+ * if the image is compressed
+ */
+static uint32_t entry_point(void) {
+    if (g_self->i_unpack != NULL) {
+        return g_self->i_unpack->os_mrg->ms_vaddr;
+    }
+
+    if (g_self->i_osentry == NULL ||
+        g_self->i_osentry->osy_globndx == EZLD_GLOB_SYM_UNDEF) {
+        ezld_runtime_message(EZLD_EMSG_WARN,
+                             "could not resolve entry point symbol '%s', "
+                             "defaulting to base of '.text' section",
+                             g_self->i_cfg.cfg_entrysym);
+        // TODO: actually default to that
+        return 0;
+    }
+
+    Elf32_Sym gsym;
+    resolve_sym(&gsym, g_self->i_osentry, EZLD_ENTRY_NAME, false);
+    return gsym.st_value;
+}
+
+/**
+ * @brief Writes a program header describing a single section, such as
+ * PT_DYNAMIC or PT_NOTE. Must be called once the section has a file offset
+ *
+ * @param type the segment type
+ * @param flags the PF_* flags of the segment
+ * @param os the section
+ * @param off the offset of the program header in the output file
+ */
+static void write_section_phdr(uint32_t        type,
+                               uint32_t        flags,
+                               ezld_obj_sec_t *os,
+                               size_t          off) {
+    ezld_mrg_sec_t *mrg  = os->os_mrg;
+    Elf32_Phdr      phdr = {0};
+    phdr.p_type          = type;
+    phdr.p_align         = mrg->ms_shdr.sh_addralign;
+    phdr.p_offset        = mrg->ms_fileoff + os->os_transl;
+    phdr.p_vaddr         = mrg->ms_vaddr + os->os_transl;
+    phdr.p_paddr         = mrg->ms_paddr + os->os_transl;
+    phdr.p_memsz         = os->os_shdr.sh_size;
+    phdr.p_filesz        = os->os_shdr.sh_size;
+    phdr.p_flags         = flags;
+    phdr                 = endian_phdr(phdr);
+    ezld_runtime_write_exact_at(&phdr,
+                                sizeof(Elf32_Phdr),
+                                off,
+                                g_self->i_cfg.cfg_outpath,
+                                g_self->i_out.out_file);
+}
+
+/**
+ * @return `true` if a merged section holds debugging information, whose
+ * relocations are applied as it is written
+ */
+static bool is_debug_section(ezld_mrg_sec_t *mrg) {
+    return !(mrg->ms_shdr.sh_flags & SHF_ALLOC) &&
+           mrg->ms_shdr.sh_type != SHT_NOBITS &&
+           strncmp(shstr_from_idx(mrg->ms_name).gs_data, ".debug", 6) == 0;
+}
+
+/**
+ * @return the size of the field patched by a relocation type supported by
+ * `apply_data_relocs` (the smallest one for ULEB128 values), 0 if unsupported
+ */
+static size_t data_reloc_width(size_t type) {
+    switch (type) {
+    case R_RISCV_32:
+    case R_RISCV_ADD32:
+    case R_RISCV_SUB32:
+    case R_RISCV_SET32:
+        return 4;
+    case R_RISCV_ADD16:
+    case R_RISCV_SUB16:
+    case R_RISCV_SET16:
+        return 2;
+    case R_RISCV_ADD8:
+    case R_RISCV_SUB8:
+    case R_RISCV_SET8:
+    case R_RISCV_SUB6:
+    case R_RISCV_SET6:
+    case R_RISCV_SET_ULEB128:
+    case R_RISCV_SUB_ULEB128:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @return the word at `p`, in the byte order of the output
+ */
+static uint32_t load_word(const uint8_t *p) {
+    uint32_t word;
+    memcpy(&word, p, sizeof word);
+    return endian32(word);
+}
+
+/**
+ * @brief Stores a word at `p`, in the byte order of the output
+ */
+static void store_word(uint8_t *p, uint32_t val) {
+    uint32_t word = endian32(val);
+    memcpy(p, &word, sizeof word);
+}
+
+/**
+ * @return the halfword at `p`, in the byte order of the output
+ */
+static uint16_t load_half(const uint8_t *p) {
+    uint16_t half;
+    memcpy(&half, p, sizeof half);
+    return endian16(half);
+}
+
+/**
+ * @brief Stores a halfword at `p`, in the byte order of the output
+ */
+static void store_half(uint8_t *p, uint16_t val) {
+    uint16_t half = endian16(val);
+    memcpy(p, &half, sizeof half);
+}
+
+/**
+ * @return the number of bytes of the ULEB128 value at `p`, or 0 if it does not
+ * end within `len` bytes
+ */
+static size_t uleb128_len(const uint8_t *p, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!(p[i] & 0x80)) {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Stores a value in the ULEB128 field at `p` without changing its size
+ */
+static void write_uleb128(uint8_t *p, size_t width, uint32_t val) {
+    for (size_t i = 0; i + 1 < width; i++) {
+        p[i] = 0x80 | (val & 0x7F);
+        val >>= 7;
+    }
+
+    p[width - 1] = val & 0x7F;
+    if ((val >> 7) != 0) {
+        ezld_runtime_message(EZLD_EMSG_ERR,
+                             "relocated ULEB128 value does not fit in %zu "
+                             "bytes, truncating",
+                             width);
+    }
+}
+
+/**
+ * @return the value of the ULEB128 field at `p`, truncated to 32 bits
+ */
+static uint32_t read_uleb128(const uint8_t *p, size_t width) {
+    uint32_t val = 0;
+
+    for (size_t i = 0; i < width && 7 * i < 32; i++) {
+        val |= (uint32_t)(p[i] & 0x7F) << (7 * i);
+    }
+
+    return val;
+}
+
+/**
+ * @brief Applies precomputed relocations to a range of the contents of a
+ * section. These are the absolute values and label differences used by
+ * debugging information, which need neither the address of the field nor
+ * anything else besides the field itself
+ *
+ * @param buf the contents of the range
+ * @param start the offset of the range in the section
+ * @param len the size of the range
+ * @param relocs the relocations whose field starts in the range
+ * @param num the number of relocations
+ */
+static void apply_data_relocs(uint8_t                 *buf,
+                              size_t                   start,
+                              size_t                   len,
+                              const ezld_data_reloc_t *relocs,
+                              size_t                   num) {
+    for (size_t i = 0; i < num; i++) {
+        uint32_t val   = relocs[i].dr_value;
+        size_t   type  = relocs[i].dr_type;
+        size_t   off   = relocs[i].dr_off - start;
+        size_t   width = data_reloc_width(type);
+        uint8_t *p     = &buf[off];
+
+        if (type == R_RISCV_SET_ULEB128 || type == R_RISCV_SUB_ULEB128) {
+            width = uleb128_len(p, len - off);
+        }
+
+        if (width == 0 || width > len - off) {
+            ezld_runtime_message(EZLD_EMSG_ERR,
+                                 "out of bounds relocation, ignoring");
+            continue;
+        }
+
+        switch (type) {
+        case R_RISCV_32:
+        case R_RISCV_SET32:
+            store_word(p, val);
+            break;
+        case R_RISCV_ADD32:
+            store_word(p, load_word(p) + val);
+            break;
+        case R_RISCV_SUB32:
+            store_word(p, load_word(p) - val);
+            break;
+        case R_RISCV_SET16:
+            store_half(p, val);
+            break;
+        case R_RISCV_ADD16:
+            store_half(p, load_half(p) + val);
+            break;
+        case R_RISCV_SUB16:
+            store_half(p, load_half(p) - val);
+            break;
+        case R_RISCV_SET8:
+            *p = val;
+            break;
+        case R_RISCV_ADD8:
+            *p += val;
+            break;
+        case R_RISCV_SUB8:
+            *p -= val;
+            break;
+        case R_RISCV_SET6:
+            *p = (*p & 0xC0) | (val & 0x3F);
+            break;
+        case R_RISCV_SUB6:
+            *p = (*p & 0xC0) | ((*p - val) & 0x3F);
+            break;
+        case R_RISCV_SET_ULEB128:
+            write_uleb128(p, width, val);
+            break;
+        case R_RISCV_SUB_ULEB128:
+            write_uleb128(p, width, read_uleb128(p, width) - val);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Applies a run of word-sized data relocations (R_RISCV_32,
+ * R_RISCV_SET32, R_RISCV_ADD32 and R_RISCV_SUB32) to the contents of a section
+ * in memory. Each of them is reduced to `word = (word & keep) + addend`, so the
+ * loop has no branches besides its own
+ *
+ * @param data the contents of the section
+ * @param relocs the relocations, whose fields must be within `data`
+ * @param num the number of relocations
+ */
+static void apply_word_relocs(uint8_t                 *data,
+                              const ezld_data_reloc_t *relocs,
+                              size_t                   num) {
+    for (size_t i = 0; i < num; i++) {
+        uint32_t type = relocs[i].dr_type;
+        uint32_t val  = relocs[i].dr_value;
+        uint8_t *p    = &data[relocs[i].dr_off];
+        uint32_t keep = -(uint32_t)(type == R_RISCV_ADD32 ||
+                                    type == R_RISCV_SUB32);
+        uint32_t add  = (type == R_RISCV_SUB32) ? -val : val;
+
+        store_word(p, (load_word(p) & keep) + add);
+    }
+}
+
+/**
+ * @brief Copies a range of the contents of an object file section, reading it
+ * from the object file unless the section is already in memory. Sections that
+ * are compressed in their object file are inflated whole
+ *
+ * @param os the section
+ * @param off the offset of the range in the section
+ * @param dst where to copy the range
+ * @param len the size of the range
+ */
+static void
+read_section_range(ezld_obj_sec_t *os, size_t off, uint8_t *dst, size_t len) {
+    if (os->os_data == NULL && os->os_zsize != 0) {
+        read_section_contents(os);
+    }
+
+    if (os->os_data != NULL) {
+        memcpy(dst, &os->os_data[off], len);
+        return;
+    }
+
+    ezld_runtime_read_exact_at(dst,
+                               len,
+                               os->os_shdr.sh_offset + off,
+                               os->os_obj->obj_filepath,
+                               os->os_obj->obj_file);
+}
+
+/**
+ * @brief Calls a function on the contents of a merged section in chunks of at
+ * most `EZLD_DEBUG_CHUNK` bytes, in order, applying the deferred relocations of
+ * each chunk on the way. Object file sections that are not in memory are never
+ * loaded whole, which keeps large debugging sections out of memory. The
+ * padding between object file sections is skipped
+ *
+ * @param mrg the merged section
+ * @param fn the function, which receives the context, the chunk, its offset
+ * in the merged section and its size
+ * @param ctx the context passed to the function
+ */
+static void visit_section(ezld_mrg_sec_t *mrg,
+                          void (*fn)(void    *ctx,
+                                     uint8_t *chunk,
+                                     size_t   off,
+                                     size_t   len),
+                          void *ctx) {
+    uint8_t *chunk = ezld_runtime_alloc(1, EZLD_DEBUG_CHUNK);
+
+    for (size_t i = 0; i < mrg->ms_oss.len; i++) {
+        ezld_obj_sec_t          *os     = mrg->ms_oss.buf[i];
+        const ezld_data_reloc_t *relocs = os->os_drelocs.buf;
+        size_t                   num    = os->os_drelocs.len;
+        size_t                   size   = os->os_shdr.sh_size;
+        size_t                   next   = 0;
+
+        for (size_t pos = 0; pos < size;) {
+            size_t end  = (size - pos > EZLD_DEBUG_CHUNK)
+                              ? pos + EZLD_DEBUG_CHUNK
+                              : size;
+            size_t last = next;
+
+            while (last < num && relocs[last].dr_off < end) {
+                last++;
+            }
+
+            // Fields are never split between chunks
+            if (end < size && last > next && relocs[last - 1].dr_off > pos &&
+                relocs[last - 1].dr_off + EZLD_DEBUG_FIELD_MAX > end) {
+                end = relocs[last - 1].dr_off;
+
+                while (last > next && relocs[last - 1].dr_off >= end) {
+                    last--;
+                }
+            }
+
+            read_section_range(os, pos, chunk, end - pos);
+            apply_data_relocs(
+                chunk, pos, end - pos, &relocs[next], last - next);
+            fn(ctx, chunk, os->os_transl + pos, end - pos);
+            pos  = end;
+            next = last;
+        }
+
+        if (os->os_island != NULL) {
+            ezld_obj_sec_t *island = os->os_island;
+            fn(ctx,
+               island->os_data,
+               island->os_transl,
+               island->os_shdr.sh_size);
+        }
+    }
+
+    free(chunk);
+}
+
+/**
+ * @brief Writes a chunk of a merged section to the output, as a function for
+ * `visit_section`
+ *
+ * @param ctx the offset in the output where the section starts
+ * @param chunk the chunk
+ * @param off the offset of the chunk in the section
+ * @param len the size of the chunk
+ */
+static void write_chunk(void *ctx, uint8_t *chunk, size_t off, size_t len) {
+    ezld_runtime_write_exact_at(chunk,
+                                len,
+                                *(size_t *)ctx + off,
+                                g_self->i_cfg.cfg_outpath,
+                                g_self->i_out.out_file);
+}
+
+/**
+ * @brief Writes a non-allocated merged section to the output without loading
+ * it whole
+ *
+ * @param mrg the merged section
+ * @param off the offset in the output where the section starts
+ */
+static void stream_section(ezld_mrg_sec_t *mrg, size_t off) {
+    visit_section(mrg, write_chunk, &off);
+}
+
+/**
+ * @brief Writes the output executable to disk (with relocations already
+ * applied to the section contents)
+ */
+static void write_exec(void) {
+    ezld_obj_sec_t *dynamic = g_self->i_dynamic;
+    Elf32_Ehdr      ehdr    = new_ehdr((dynamic != NULL) ? ET_DYN : ET_EXEC);
+    ehdr.e_entry            = entry_point();
+
+    // The note is not in the file if its segment was compressed
+    bool note = g_self->i_buildid != NULL &&
+                g_self->i_buildid->os_mrg->ms_shdr.sh_type != SHT_NOBITS;
+
+    // Header will be added later
+    ezld_runtime_seek(
+        sizeof(Elf32_Ehdr), g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+
+    ehdr.e_phoff     = sizeof(Elf32_Ehdr);
+    ehdr.e_phentsize = sizeof(Elf32_Phdr);
+    ehdr.e_shnum     = 1; // NULL, ...
+    ehdr.e_phnum     = g_self->i_segs.len + (dynamic != NULL) + note;
+    size_t phdrs_end = ehdr.e_phoff + ehdr.e_phnum * sizeof(Elf32_Phdr);
+
+    // Segments are placed at the first offset that satisfies p_offset = p_vaddr
+    // (mod p_align) in compact mode, and at the next multiple of p_align
+    // otherwise
+    size_t seg_off = phdrs_end;
+    for (size_t i = 0; i < g_self->i_segs.len; i++) {
+        ezld_out_seg_t *seg  = &g_self->i_segs.buf[i];
+        Elf32_Phdr      phdr = {0};
+        phdr.p_type          = PT_LOAD;
+        phdr.p_align         = g_self->i_cfg.cfg_segalign;
+        phdr.p_vaddr         = seg->sg_vaddr;
+        phdr.p_paddr         = seg->sg_paddr;
+        phdr.p_memsz         = seg->sg_memsz;
+        phdr.p_filesz        = seg->sg_filesz;
+        phdr.p_flags         = seg->sg_flags;
+
+        if (g_self->i_cfg.cfg_compact && phdr.p_align > 1) {
+            seg_off += (phdr.p_vaddr % phdr.p_align + phdr.p_align -
+                        seg_off % phdr.p_align) %
+                       phdr.p_align;
+        } else {
+            seg_off = align_up(seg_off, phdr.p_align);
+        }
+
+        phdr.p_offset = seg_off;
+
+        // The first segment is extended downwards to the beginning of the file
+        // so that the headers are loaded too. This is possible as long as the
+        // segment does not start at an address lower than its offset
+        if (i == 0 && g_self->i_cfg.cfg_hdrload) {
+            if (phdr.p_vaddr >= seg_off) {
+                phdr.p_offset = 0;
+                phdr.p_vaddr -= seg_off;
+                phdr.p_paddr -= seg_off;
+                phdr.p_memsz += seg_off;
+                phdr.p_filesz += seg_off;
+            } else {
+                ezld_runtime_message(EZLD_EMSG_WARN,
+                                     "no room for headers below address "
+                                     "0x%08x, not loading them",
+                                     phdr.p_vaddr);
+            }
+        }
+
+        for (size_t j = 0; j < seg->sg_mss.len; j++) {
+            ezld_mrg_sec_t *sec = seg->sg_mss.buf[j];
+            sec->ms_fileoff     = seg_off + (sec->ms_vaddr - seg->sg_vaddr);
+            (void)write_segment(sec,
+                                sec->ms_fileoff,
+                                g_self->i_cfg.cfg_outpath,
+                                g_self->i_out.out_file);
+        }
+
+        seg_off += seg->sg_filesz;
+        phdr = endian_phdr(phdr);
+        ezld_runtime_write_exact_at(&phdr,
+                                    sizeof(Elf32_Phdr),
+                                    ehdr.e_phoff + i * sizeof(Elf32_Phdr),
+                                    g_self->i_cfg.cfg_outpath,
+                                    g_self->i_out.out_file);
+    }
+
+    size_t phndx = g_self->i_segs.len;
+
+    if (dynamic != NULL) {
+        write_section_phdr(PT_DYNAMIC,
+                           PF_R | PF_W,
+                           dynamic,
+                           ehdr.e_phoff + phndx++ * sizeof(Elf32_Phdr));
+    }
+
+    if (note) {
+        write_section_phdr(PT_NOTE,
+                           PF_R,
+                           g_self->i_buildid,
+                           ehdr.e_phoff + phndx++ * sizeof(Elf32_Phdr));
+    }
+
+    // Sections that are not loaded follow the segments, and their headers
+    // follow those of the merged sections
+    ezld_shdrs_t tail_shdrs = ezld_array_new();
+    size_t       num_secs   = number_sections();
+    size_t       tail_off   = seg_off;
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (mrg->ms_outndx == 0 || (mrg->ms_shdr.sh_flags & SHF_ALLOC) ||
+            mrg->ms_shdr.sh_type == SHT_NOBITS) {
+            continue;
+        }
+
+        if (mrg->ms_zdata != NULL) {
+            mrg->ms_fileoff = align_up(tail_off, 4);
+            ezld_runtime_write_exact_at(mrg->ms_zdata,
+                                        mrg->ms_zsize,
+                                        mrg->ms_fileoff,
+                                        g_self->i_cfg.cfg_outpath,
+                                        g_self->i_out.out_file);
+            tail_off = mrg->ms_fileoff + mrg->ms_zsize;
+        } else {
+            mrg->ms_fileoff = align_up(tail_off, mrg->ms_shdr.sh_addralign);
+            stream_section(mrg, mrg->ms_fileoff);
+            tail_off = mrg->ms_fileoff + mrg->ms_memsz;
+        }
+    }
+
+    // Relocations kept for post-link optimizers refer to the symbol table
+    if (!g_self->i_cfg.cfg_stripall || g_self->i_cfg.cfg_emitrelocs) {
+        ezld_out_symtab_t symtab;
+        build_symtab(&symtab, false);
+
+        if (g_self->i_cfg.cfg_emitrelocs) {
+            collect_relocs(false);
+        }
+
+        tail_off =
+            write_symtab_relas(&symtab, tail_off, num_secs + 1, &tail_shdrs);
+        ezld_array_free(symtab.ot_syms);
+        ezld_array_free(symtab.ot_strs);
+    }
+
+    ezld_runtime_seek(
+        tail_off, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+    *ezld_array_push(tail_shdrs) =
+        write_strtab(".shstrtab", &g_self->i_shstrtab);
+
+    ehdr.e_shoff = ftell(g_self->i_out.out_file);
+
+    Elf32_Shdr null_shdr = {0};
     // TODO: set something?
     ezld_runtime_write_exact(&null_shdr,
                              sizeof(Elf32_Shdr),
                              g_self->i_cfg.cfg_outpath,
                              g_self->i_out.out_file);
 
-    for (size_t i = 0; i < g_self->i_mss.len; i++) {
-        ezld_mrg_sec_t *s = &g_self->i_mss.buf[i];
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *s = g_self->i_mss.buf[i];
+
+        if (!ezld_array_is_empty(s->ms_oss)) {
+            Elf32_Shdr shdr = s->ms_shdr;
+            shdr.sh_size    = s->ms_memsz;
+            shdr.sh_name    = shstr_from_idx(s->ms_name).gs_offset;
+            shdr.sh_addr    = s->ms_vaddr;
+            shdr.sh_offset  = s->ms_fileoff;
+
+            if (s->ms_zdata != NULL) {
+                shdr.sh_flags |= SHF_COMPRESSED;
+                shdr.sh_size      = s->ms_zsize;
+                shdr.sh_addralign = 4;
+            }
+
+            shdr = endian_shdr(shdr);
+            ezld_runtime_write_exact(&shdr,
+                                     sizeof(Elf32_Shdr),
+                                     g_self->i_cfg.cfg_outpath,
+                                     g_self->i_out.out_file);
+            ehdr.e_shnum++;
+        }
+    }
+
+    ezld_runtime_write_exact(tail_shdrs.buf,
+                             tail_shdrs.len * sizeof(Elf32_Shdr),
+                             g_self->i_cfg.cfg_outpath,
+                             g_self->i_out.out_file);
+    ehdr.e_shnum += tail_shdrs.len;
+    ezld_array_free(tail_shdrs);
+
+    ehdr.e_shstrndx = ehdr.e_shnum - 1;
+    ehdr            = endian_ehdr(ehdr);
+    ezld_runtime_seek(0, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+    ezld_runtime_write_exact(&ehdr,
+                             sizeof(Elf32_Ehdr),
+                             g_self->i_cfg.cfg_outpath,
+                             g_self->i_out.out_file);
+}
+
+/**
+ * @brief Writes a record of an Intel HEX file to the output
+ *
+ * @param type the record type
+ * @param addr the 16-bit address field
+ * @param data the data bytes
+ * @param len the number of data bytes (at most `EZLD_HEX_RECORD_LEN`)
+ */
+static void write_ihex_record(uint8_t        type,
+                              uint16_t       addr,
+                              const uint8_t *data,
+                              size_t         len) {
+    char    line[16 + 2 * EZLD_HEX_RECORD_LEN];
+    uint8_t sum = len + (addr >> 8) + (addr & 0xFF) + type;
+    int     n   = sprintf(line, ":%02X%04X%02X", (unsigned)len, addr, type);
+
+    for (size_t i = 0; i < len; i++) {
+        n += sprintf(&line[n], "%02X", data[i]);
+        sum += data[i];
+    }
+
+    n += sprintf(&line[n], "%02X\r\n", (uint8_t)-sum);
+    ezld_runtime_write_exact(
+        line, n, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+}
+
+/**
+ * @brief Writes a record of a Motorola S-record file to the output
+ *
+ * @param type the record type ('0', '3', or '7')
+ * @param addr the address field, which is 16 bits wide for S0 records and 32
+ * bits wide otherwise
+ * @param data the data bytes
+ * @param len the number of data bytes (at most `EZLD_HEX_RECORD_LEN`)
+ */
+static void write_srec_record(char           type,
+                              uint32_t       addr,
+                              const uint8_t *data,
+                              size_t         len) {
+    char    line[24 + 2 * EZLD_HEX_RECORD_LEN];
+    int     addr_len = (type == '0') ? 2 : 4;
+    uint8_t count    = len + addr_len + 1;
+    uint8_t sum      = count + (addr >> 24) + (addr >> 16) + (addr >> 8) + addr;
+    int     n        = sprintf(
+        line, "S%c%02X%0*X", type, count, addr_len * 2, (unsigned)addr);
+
+    for (size_t i = 0; i < len; i++) {
+        n += sprintf(&line[n], "%02X", data[i]);
+        sum += data[i];
+    }
+
+    n += sprintf(&line[n], "%02X\r\n", (uint8_t)~sum);
+    ezld_runtime_write_exact(
+        line, n, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+}
+
+/**
+ * @brief Copies the contents of a merged section, including the padding
+ * between object file sections, into a new buffer
+ *
+ * @param mrg the merged section, which must not be SHT_NOBITS
+ *
+ * @return the buffer, `ms_memsz` bytes long
+ */
+static uint8_t *section_image(ezld_mrg_sec_t *mrg) {
+    uint8_t *buf = ezld_runtime_alloc(1, mrg->ms_memsz ? mrg->ms_memsz : 1);
+    memset(buf, 0, mrg->ms_memsz);
+
+    for (size_t i = 0; i < mrg->ms_oss.len; i++) {
+        ezld_obj_sec_t *os  = mrg->ms_oss.buf[i];
+        uint8_t        *dst = &buf[os->os_transl];
+        read_section_range(os, 0, dst, os->os_shdr.sh_size);
+        apply_data_relocs(dst,
+                          0,
+                          os->os_shdr.sh_size,
+                          os->os_drelocs.buf,
+                          os->os_drelocs.len);
+
+        if (os->os_island != NULL) {
+            ezld_obj_sec_t *island = os->os_island;
+            memcpy(&buf[island->os_transl],
+                   island->os_data,
+                   island->os_shdr.sh_size);
+        }
+    }
+
+    return buf;
+}
+
+/**
+ * @brief Copies the file-backed part of a segment, with the padding between
+ * its sections zero-filled, into a new buffer
+ *
+ * @param seg the segment
+ *
+ * @return the buffer, `sg_filesz` bytes long
+ */
+static uint8_t *segment_image(ezld_out_seg_t *seg) {
+    uint8_t *img = ezld_runtime_alloc(1, seg->sg_filesz ? seg->sg_filesz : 1);
+    memset(img, 0, seg->sg_filesz);
+
+    for (size_t i = 0; i < seg->sg_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = seg->sg_mss.buf[i];
+
+        if (mrg->ms_shdr.sh_type != SHT_NOBITS) {
+            uint8_t *buf = section_image(mrg);
+            memcpy(&img[mrg->ms_vaddr - seg->sg_vaddr], buf, mrg->ms_memsz);
+            free(buf);
+        }
+    }
+
+    return img;
+}
+
+/**
+ * @brief Writes the contents of the loadable sections to disk as a flat binary
+ * image starting at the lowest load address, with gaps filled with zeros, or as
+ * an Intel HEX or S-record stream. Sections are written at their load
+ * addresses, with relocations already applied
+ */
+static void write_image(void) {
+    ezld_array(ezld_mrg_sec_t *) secs = ezld_array_new();
+    uint32_t base                     = UINT32_MAX;
+    uint32_t entry                    = entry_point();
+    uint32_t ext_addr                 = 0;
+    int      oformat                  = g_self->i_cfg.cfg_oformat;
+
+    // Segments list allocated sections in address order
+    for (size_t i = 0; i < g_self->i_segs.len; i++) {
+        ezld_out_seg_t *seg = &g_self->i_segs.buf[i];
+
+        for (size_t j = 0; j < seg->sg_mss.len; j++) {
+            ezld_mrg_sec_t *mrg = seg->sg_mss.buf[j];
+
+            if (mrg->ms_shdr.sh_type != SHT_NOBITS && mrg->ms_memsz != 0) {
+                *ezld_array_push(secs) = mrg;
+                base = (mrg->ms_paddr < base) ? mrg->ms_paddr : base;
+            }
+        }
+    }
+
+    if (oformat == EZLD_OFORMAT_SREC) {
+        const char *hdr = "ezld";
+        write_srec_record('0', 0, (const uint8_t *)hdr, strlen(hdr));
+    }
+
+    for (size_t i = 0; i < secs.len; i++) {
+        ezld_mrg_sec_t *mrg = secs.buf[i];
+
+        // Flat images are written in place, so that the gaps in between are
+        // zero-filled by the file system
+        if (oformat == EZLD_OFORMAT_BINARY) {
+            (void)write_segment(mrg,
+                                mrg->ms_paddr - base,
+                                g_self->i_cfg.cfg_outpath,
+                                g_self->i_out.out_file);
+            continue;
+        }
+
+        uint8_t *buf = section_image(mrg);
+
+        for (size_t off = 0; off < mrg->ms_memsz;) {
+            uint32_t addr = mrg->ms_paddr + off;
+            size_t   len  = mrg->ms_memsz - off;
+
+            if (len > EZLD_HEX_RECORD_LEN) {
+                len = EZLD_HEX_RECORD_LEN;
+            }
+
+            if (oformat == EZLD_OFORMAT_SREC) {
+                write_srec_record('3', addr, &buf[off], len);
+                off += len;
+                continue;
+            }
+
+            // Intel HEX records can not cross a 64 KiB boundary, past which an
+            // extended linear address record is needed
+            if ((addr & 0xFFFF) + len > 0x10000) {
+                len = 0x10000 - (addr & 0xFFFF);
+            }
+
+            if ((addr >> 16) != ext_addr) {
+                uint8_t ext[2] = {addr >> 24, addr >> 16};
+                ext_addr       = addr >> 16;
+                write_ihex_record(EZLD_IHEX_EXT_LINEAR_ADDR, 0, ext, 2);
+            }
+
+            write_ihex_record(EZLD_IHEX_DATA, addr & 0xFFFF, &buf[off], len);
+            off += len;
+        }
+
+        free(buf);
+    }
+
+    if (oformat == EZLD_OFORMAT_IHEX) {
+        uint8_t start[4] = {entry >> 24, entry >> 16, entry >> 8, entry};
+        write_ihex_record(EZLD_IHEX_START_LINEAR_ADDR, 0, start, 4);
+        write_ihex_record(EZLD_IHEX_EOF, 0, NULL, 0);
+    } else if (oformat == EZLD_OFORMAT_SREC) {
+        write_srec_record('7', entry, NULL, 0);
+    }
+
+    ezld_array_free(secs);
+}
+
+/**
+ * @brief Unpacking stub placed at the entry point of compressed images (RV32I
+ * with Zifencei, position independent). It is followed by the address of the
+ * real entry point, the number of entries of the unpacking table, and the
+ * table itself, whose entries are the start and end addresses of an LZ4 block
+ * followed by those of the segment to inflate it to. The part of the segment
+ * past the end of the inflated data is zero-filled
+ */
+static const uint32_t g_unpack_stub[] = {
+    0x00000517, // auipc a0, 0
+    0x0E852583, // lw a1, hdr+4(a0)
+    0x0EC50513, // addi a0, a0, hdr+8
+    0x00F00F93, // li t6, 15
+    0x0FF00713, // li a4, 255
+    // next:
+    0x0C058063, // beqz a1, done
+    0x00052283, // lw t0, 0(a0)
+    0x00452303, // lw t1, 4(a0)
+    0x00852383, // lw t2, 8(a0)
+    0x00C52E03, // lw t3, 12(a0)
+    0x01050513, // addi a0, a0, 16
+    0xFFF58593, // addi a1, a1, -1
+    // seq:
+    0x0862FA63, // bgeu t0, t1, fill
+    0x0002CE83, // lbu t4, 0(t0)
+    0x00128293, // addi t0, t0, 1
+    0x004EDF13, // srli t5, t4, 4
+    0x01FF1A63, // bne t5, t6, lit
+    // litext:
+    0x0002C603, // lbu a2, 0(t0)
+    0x00128293, // addi t0, t0, 1
+    0x00CF0F33, // add t5, t5, a2
+    0xFEE60AE3, // beq a2, a4, litext
+    // lit:
+    0x000F0E63, // beqz t5, match
+    // litcpy:
+    0x0002C603, // lbu a2, 0(t0)
+    0x00C38023, // sb a2, 0(t2)
+    0x00128293, // addi t0, t0, 1
+    0x00138393, // addi t2, t2, 1
+    0xFFFF0F13, // addi t5, t5, -1
+    0xFE0F16E3, // bnez t5, litcpy
+    // match:
+    0x0462FA63, // bgeu t0, t1, fill
+    0x0002C603, // lbu a2, 0(t0)
+    0x0012C683, // lbu a3, 1(t0)
+    0x00228293, // addi t0, t0, 2
+    0x00869693, // slli a3, a3, 8
+    0x00D66633, // or a2, a2, a3
+    0x40C386B3, // sub a3, t2, a2
+    0x00FEFF13, // andi t5, t4, 15
+    0x01FF1A63, // bne t5, t6, mlen
+    // mext:
+    0x0002C603, // lbu a2, 0(t0)
+    0x00128293, // addi t0, t0, 1
+    0x00CF0F33, // add t5, t5, a2
+    0xFEE60AE3, // beq a2, a4, mext
+    // mlen:
+    0x004F0F13, // addi t5, t5, 4
+    // mcpy:
+    0x0006C603, // lbu a2, 0(a3)
+    0x00C38023, // sb a2, 0(t2)
+    0x00168693, // addi a3, a3, 1
+    0x00138393, // addi t2, t2, 1
+    0xFFFF0F13, // addi t5, t5, -1
+    0xFE0F16E3, // bnez t5, mcpy
+    0xF71FF06F, // j seq
+    // fill:
+    0xF5C3F8E3, // bgeu t2, t3, next
+    0x00038023, // sb zero, 0(t2)
+    0x00138393, // addi t2, t2, 1
+    0xFF5FF06F, // j fill
+    // done:
+    0x0000100F, // fence.i
+    0x00000297, // auipc t0, 0
+    0x00C2A283, // lw t0, hdr-done-4(t0)
+    0x00028067, // jr t0
+    // hdr:
+};
+
+/**
+ * @brief Compresses a non-allocated section, as an iteration of
+ * `ezld_runtime_parallel_for`
+ *
+ * @param ctx the array of `ezld_zjob_t`
+ * @param ndx the index of the section in `ctx`
+ */
+static void compress_section(void *ctx, size_t ndx) {
+    ezld_zjob_t    *job  = &((ezld_zjob_t *)ctx)[ndx];
+    ezld_mrg_sec_t *mrg  = job->zj_mrg;
+    size_t          size = mrg->ms_memsz;
+
+    job->zj_zsize = sizeof(Elf32_Chdr) +
+                    ezld_deflate_zlib(&job->zj_zdata[sizeof(Elf32_Chdr)],
+                                      job->zj_data,
+                                      size,
+                                      job->zj_tabs);
+
+    Elf32_Chdr chdr   = {0};
+    chdr.ch_type      = endian32(ELFCOMPRESS_ZLIB);
+    chdr.ch_size      = endian32(size);
+    chdr.ch_addralign = endian32(
+        mrg->ms_shdr.sh_addralign ? mrg->ms_shdr.sh_addralign : 1);
+    memcpy(job->zj_zdata, &chdr, sizeof(Elf32_Chdr));
+}
+
+/**
+ * @brief Compresses the debugging sections of the output with zlib. Their
+ * contents are gathered first, since object files can not be read concurrently,
+ * and then compressed in parallel. Sections are left uncompressed if that does
+ * not make them smaller
+ */
+static void compress_debug_sections(void) {
+    ezld_array(ezld_zjob_t) jobs = ezld_array_new();
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (ezld_array_is_empty(mrg->ms_oss) || mrg->ms_memsz == 0 ||
+            !is_debug_section(mrg)) {
+            continue;
+        }
+
+        ezld_zjob_t *job = ezld_array_push(jobs);
+        job->zj_mrg      = mrg;
+        job->zj_data     = section_image(mrg);
+        job->zj_zdata    = ezld_runtime_alloc(
+            1, sizeof(Elf32_Chdr) + ezld_deflate_bound(mrg->ms_memsz));
+        job->zj_tabs = ezld_runtime_alloc(1, sizeof(ezld_deflate_tabs_t));
+    }
+
+    ezld_runtime_parallel_for(jobs.len, compress_section, jobs.buf);
+
+    for (size_t i = 0; i < jobs.len; i++) {
+        ezld_zjob_t *job = &jobs.buf[i];
+
+        if (job->zj_zsize < job->zj_mrg->ms_memsz) {
+            job->zj_mrg->ms_zdata = job->zj_zdata;
+            job->zj_mrg->ms_zsize = job->zj_zsize;
+        } else {
+            free(job->zj_zdata);
+        }
+
+        free(job->zj_data);
+        free(job->zj_tabs);
+    }
+
+    ezld_array_free(jobs);
+}
+
+/**
+ * @brief Compresses the loadable segments and replaces them with a new segment
+ * at the address requested by the configuration, which holds the unpacking
+ * stub, its table, and the LZ4 blocks. The original segments are kept in the
+ * output with no file contents, so that their memory is still described, and
+ * their sections become SHT_NOBITS. The entry point is moved to the stub, which
+ * jumps to the real one after inflating the segments
+ */
+static void compress_segments(void) {
+    size_t   nsegs   = g_self->i_segs.len;
+    uint32_t entry   = entry_point();
+    uint32_t addr    = g_self->i_cfg.cfg_compressaddr;
+    size_t   hdr_off = sizeof g_unpack_stub;
+    size_t   blk_off = hdr_off + 8 + nsegs * EZLD_UNPACK_ENT_SIZE;
+    size_t   size    = blk_off;
+
+    uint8_t **blocks = ezld_runtime_alloc(sizeof(uint8_t *), nsegs + 1);
+    size_t   *blksz  = ezld_runtime_alloc(sizeof(size_t), nsegs + 1);
+
+    if (addr % 4 != 0) {
+        ezld_runtime_exit(EZLD_ECODE_BADPARAM,
+                          "unpacking stub address 0x%08x is not aligned to "
+                          "4 bytes",
+                          addr);
+    }
+
+    for (size_t i = 0; i < nsegs; i++) {
+        ezld_out_seg_t *seg = &g_self->i_segs.buf[i];
+        uint8_t        *img = segment_image(seg);
+
+        for (size_t j = 0; j < seg->sg_mss.len; j++) {
+            seg->sg_mss.buf[j]->ms_shdr.sh_type = SHT_NOBITS;
+        }
+
+        blocks[i] = ezld_runtime_alloc(1, ezld_lz4_bound(seg->sg_filesz));
+        blksz[i]  = ezld_lz4_compress(blocks[i], img, seg->sg_filesz);
+        size += blksz[i];
+        free(img);
+    }
+
+    for (size_t i = 0; i < nsegs; i++) {
+        ezld_out_seg_t *seg = &g_self->i_segs.buf[i];
+
+        if (addr < seg->sg_vaddr + seg->sg_memsz &&
+            seg->sg_vaddr < addr + size) {
+            ezld_runtime_exit(EZLD_ECODE_BADPARAM,
+                              "unpacking stub at 0x%08x (%zu bytes) overlaps "
+                              "segment at 0x%08x",
+                              addr,
+                              size,
+                              seg->sg_vaddr);
+        }
+    }
+
+    Elf32_Shdr shdr = {.sh_type      = SHT_PROGBITS,
+                       .sh_flags     = SHF_ALLOC | SHF_EXECINSTR,
+                       .sh_addralign = 4,
+                       .sh_size      = size};
+    ezld_obj_sec_t *unpack = new_synth_section(".lz4boot", shdr);
+    unpack->os_data        = ezld_runtime_alloc(1, size);
+    merge_section(unpack);
+
+    for (size_t i = 0; i < sizeof g_unpack_stub / sizeof *g_unpack_stub; i++) {
+        uint32_t insn = endian32(g_unpack_stub[i]);
+        memcpy(&unpack->os_data[i * 4], &insn, sizeof insn);
+    }
+
+    uint32_t hdr[2] = {endian32(entry), endian32(nsegs)};
+    memcpy(&unpack->os_data[hdr_off], hdr, sizeof hdr);
+
+    for (size_t i = 0, off = blk_off; i < nsegs; off += blksz[i], i++) {
+        ezld_out_seg_t *seg    = &g_self->i_segs.buf[i];
+        uint32_t        ent[4] = {endian32(addr + off),
+                                  endian32(addr + off + blksz[i]),
+                                  endian32(seg->sg_vaddr),
+                                  endian32(seg->sg_vaddr + seg->sg_memsz)};
+        memcpy(&unpack->os_data[hdr_off + 8 + i * EZLD_UNPACK_ENT_SIZE],
+               ent,
+               sizeof ent);
+        memcpy(&unpack->os_data[off], blocks[i], blksz[i]);
+        seg->sg_filesz = 0;
+        free(blocks[i]);
+    }
+
+    ezld_mrg_sec_t *mrg       = unpack->os_mrg;
+    mrg->ms_vaddr             = addr;
+    mrg->ms_paddr             = addr;
+    mrg->ms_memsz             = size;
+    mrg->ms_shdr.sh_addralign = shdr.sh_addralign;
+
+    ezld_out_seg_t *seg = ezld_array_push(g_self->i_segs);
+    seg->sg_vaddr       = addr;
+    seg->sg_paddr       = addr;
+    seg->sg_memsz       = size;
+    seg->sg_filesz      = size;
+    seg->sg_flags       = PF_R | PF_X;
+    ezld_array_init(seg->sg_mss);
+    *ezld_array_push(seg->sg_mss) = mrg;
+
+    g_self->i_unpack = unpack;
+    free(blocks);
+    free(blksz);
+}
+
+/**
+ * @brief Computes a CRC32 (or CRC32C) over the file-backed contents of all
+ * loadable segments, in program header order, and stores it at the location of
+ * the symbol named by the configuration. The location is zeroed before the
+ * CRC is computed, so that the loader can check the image by zeroing it again
+ */
+static void write_image_crc(void) {
+    const char *name = g_self->i_cfg.cfg_crcsym;
+    size_t      ndx  = resolve_sym(NULL, NULL, globstr_add(name), false);
+    uint32_t    poly = 0xEDB88320;
+    uint32_t    crc  = 0xFFFFFFFF;
+    uint32_t(*tables)[256] = ezld_runtime_alloc(sizeof(uint32_t[256]), 16);
+
+    if (ndx == EZLD_GLOB_SYM_UNDEF) {
+        ezld_runtime_exit(
+            EZLD_ECODE_BADSYM, "undefined image CRC symbol '%s'", name);
+    }
+
+    ezld_glob_sym_t *gsym = &g_self->i_globsymtab.buf[ndx - 1];
+    ezld_obj_sec_t  *os   = gsym->gsy_os;
+
+    if (os->os_mrgsyn != NULL || os->os_shdr.sh_type == SHT_NOBITS ||
+        !(os->os_shdr.sh_flags & SHF_ALLOC) ||
+        gsym->gsy_off + sizeof crc > os->os_shdr.sh_size) {
+        ezld_runtime_exit(EZLD_ECODE_BADSYM,
+                          "image CRC symbol '%s' does not refer to 4 bytes "
+                          "of loaded data",
+                          name);
+    }
+
+    if (g_self->i_cfg.cfg_crcalgo == EZLD_IMAGE_CRC32C) {
+        poly = 0x82F63B78;
+    }
+
+    read_section_contents(os);
+    memset(&os->os_data[gsym->gsy_off], 0, sizeof crc);
+    ezld_hash_crc32_tables(tables, poly);
+
+    for (size_t i = 0; i < g_self->i_segs.len; i++) {
+        ezld_out_seg_t *seg = &g_self->i_segs.buf[i];
+        uint8_t        *img = segment_image(seg);
+        crc                 = ezld_hash_crc32_update(
+            tables, crc, img, seg->sg_filesz);
+        free(img);
+    }
+
+    crc = endian32(~crc);
+    memcpy(&os->os_data[gsym->gsy_off], &crc, sizeof crc);
+    free(tables);
+}
+
+/**
+ * @param kind one of the `EZLD_BUILD_ID_*` values
+ *
+ * @return the size of the build ID
+ */
+static size_t build_id_size(int kind) {
+    switch (kind) {
+    case EZLD_BUILD_ID_FAST:
+        return EZLD_BUILD_ID_FAST_SIZE;
+    case EZLD_BUILD_ID_SHA1:
+        return EZLD_BUILD_ID_SHA1_SIZE;
+    default:
+        return EZLD_BUILD_ID_UUID_SIZE;
+    }
+}
+
+/**
+ * @brief Hashes a buffer with the hash function of a build ID kind
+ *
+ * @param kind `EZLD_BUILD_ID_FAST` or `EZLD_BUILD_ID_SHA1`
+ * @param data the buffer
+ * @param len the length of the buffer
+ * @param digest where to store the digest, `build_id_size(kind)` bytes long
+ */
+static void build_id_digest(int            kind,
+                            const uint8_t *data,
+                            size_t         len,
+                            uint8_t       *digest) {
+    if (kind == EZLD_BUILD_ID_SHA1) {
+        ezld_hash_sha1(data, len, digest);
+        return;
+    }
+
+    uint64_t h = ezld_hash_xxh64(data, len, 0);
+    for (size_t i = 0; i < EZLD_BUILD_ID_FAST_SIZE; i++) {
+        digest[i] = h >> (8 * (EZLD_BUILD_ID_FAST_SIZE - 1 - i));
+    }
+}
+
+/**
+ * @brief Hashes one of the blocks waiting in a build ID hash, as an iteration
+ * of `ezld_runtime_parallel_for`
+ *
+ * @param ctx the `ezld_build_hash_t` state
+ * @param ndx the index of the block in `bh_data`
+ */
+static void hash_block(void *ctx, size_t ndx) {
+    ezld_build_hash_t *bh  = ctx;
+    size_t             off = ndx * EZLD_BUILD_ID_BLOCK;
+    size_t             len = bh->bh_len - off;
+
+    if (len > EZLD_BUILD_ID_BLOCK) {
+        len = EZLD_BUILD_ID_BLOCK;
+    }
+
+    build_id_digest(bh->bh_kind,
+                    &bh->bh_data[off],
+                    len,
+                    &bh->bh_digests[(bh->bh_first + ndx) * bh->bh_digestsz]);
+}
+
+/**
+ * @brief Hashes the blocks waiting in a build ID hash in parallel, which
+ * empties it. An output with no contents at all is hashed as one empty block
+ *
+ * @param bh the build ID hash
+ */
+static void hash_flush(ezld_build_hash_t *bh) {
+    size_t num = (bh->bh_len + EZLD_BUILD_ID_BLOCK - 1) / EZLD_BUILD_ID_BLOCK;
+    if (num == 0 && bh->bh_pos == 0) {
+        num = 1;
+    }
+
+    ezld_runtime_parallel_for(num, hash_block, bh);
+    bh->bh_first += num;
+    bh->bh_len    = 0;
+}
+
+/**
+ * @brief Adds contents to a build ID hash, hashing the blocks waiting in it
+ * whenever they fill its buffer
+ *
+ * @param bh the build ID hash
+ * @param data the contents, or `NULL` for zeros
+ * @param len the size of the contents
+ */
+static void
+hash_append(ezld_build_hash_t *bh, const uint8_t *data, size_t len) {
+    const size_t cap = EZLD_BUILD_ID_BATCH * EZLD_BUILD_ID_BLOCK;
+
+    while (len != 0) {
+        size_t take = (len < cap - bh->bh_len) ? len : cap - bh->bh_len;
+
+        if (data != NULL) {
+            memcpy(&bh->bh_data[bh->bh_len], data, take);
+            data += take;
+        } else {
+            memset(&bh->bh_data[bh->bh_len], 0, take);
+        }
+
+        bh->bh_len += take;
+        bh->bh_pos += take;
+        len        -= take;
+
+        if (bh->bh_len == cap) {
+            hash_flush(bh);
+        }
+    }
+}
+
+/**
+ * @brief Adds a chunk of a merged section to a build ID hash, preceded by the
+ * padding skipped since the last one, as a function for `visit_section`
+ *
+ * @param ctx the `ezld_build_hash_t` state
+ * @param chunk the chunk
+ * @param off the offset of the chunk in the section
+ * @param len the size of the chunk
+ */
+static void hash_chunk(void *ctx, uint8_t *chunk, size_t off, size_t len) {
+    ezld_build_hash_t *bh = ctx;
+    hash_append(bh, NULL, bh->bh_base + off - bh->bh_pos);
+    hash_append(bh, chunk, len);
+}
+
+/**
+ * @brief Creates the `.note.gnu.build-id` section, whose descriptor is left
+ * zeroed until `write_build_id` fills it
+ */
+static void setup_build_id(void) {
+    int kind = g_self->i_cfg.cfg_buildid;
+
+    if (kind == EZLD_BUILD_ID_NONE || g_self->i_cfg.cfg_relocatable) {
+        return;
+    }
+
+    size_t     size   = build_id_size(kind);
+    Elf32_Shdr shdr   = {0};
+    shdr.sh_type      = SHT_NOTE;
+    shdr.sh_flags     = SHF_ALLOC;
+    shdr.sh_addralign = 4;
+    shdr.sh_size      = sizeof(Elf32_Nhdr) + 4 + align_up(size, 4);
+
+    ezld_obj_sec_t *note = new_synth_section(".note.gnu.build-id", shdr);
+    note->os_data        = ezld_runtime_alloc(1, shdr.sh_size);
+    memset(note->os_data, 0, shdr.sh_size);
+
+    Elf32_Nhdr nhdr = {.n_namesz = endian32(4),
+                       .n_descsz = endian32(size),
+                       .n_type   = endian32(NT_GNU_BUILD_ID)};
+    memcpy(note->os_data, &nhdr, sizeof nhdr);
+    memcpy(&note->os_data[sizeof nhdr], "GNU", 4);
+
+    g_self->i_buildid = note;
+    merge_section(note);
+}
+
+/**
+ * @brief Computes the build ID and stores it in the build ID note. Hashed
+ * build IDs cover the contents of all file-backed merged sections, in order,
+ * with relocations applied and the build ID itself zeroed. These are split in
+ * blocks of `EZLD_BUILD_ID_BLOCK` bytes, and the build ID is the hash of their
+ * digests. Sections are read in chunks and blocks are hashed in parallel a
+ * batch at a time, so the output is never in memory whole. UUIDs are random
+ * instead
+ */
+static void write_build_id(void) {
+    ezld_obj_sec_t *note = g_self->i_buildid;
+    int             kind = g_self->i_cfg.cfg_buildid;
+    size_t          size = build_id_size(kind);
+    uint8_t        *desc = &note->os_data[sizeof(Elf32_Nhdr) + 4];
+
+    if (kind == EZLD_BUILD_ID_UUID) {
+        // Not suitable for cryptography, but unlikely to ever repeat
+        struct timespec ts = {0};
+        (void)timespec_get(&ts, TIME_UTC);
+        uint64_t seed[4] = {
+            ts.tv_sec, ts.tv_nsec, clock(), (uintptr_t)&ts ^ (uintptr_t)note};
+
+        for (size_t i = 0; i < size; i++) {
+            uint64_t h =
+                ezld_hash_xxh64((uint8_t *)seed, sizeof seed, i / 8);
+            desc[i]    = h >> (8 * (i % 8));
+        }
+
+        // Version 4 (random), RFC 4122 variant
+        desc[6] = (desc[6] & 0x0F) | 0x40;
+        desc[8] = (desc[8] & 0x3F) | 0x80;
+        return;
+    }
+
+    size_t len = 0;
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (mrg->ms_shdr.sh_type != SHT_NOBITS) {
+            len += mrg->ms_memsz;
+        }
+    }
+
+    size_t nblocks = (len + EZLD_BUILD_ID_BLOCK - 1) / EZLD_BUILD_ID_BLOCK;
+    if (nblocks == 0) {
+        nblocks = 1;
+    }
+
+    ezld_build_hash_t bh = {
+        .bh_data     = ezld_runtime_alloc(EZLD_BUILD_ID_BLOCK,
+                                      EZLD_BUILD_ID_BATCH),
+        .bh_kind     = kind,
+        .bh_digestsz = size,
+        .bh_digests  = ezld_runtime_alloc(size, nblocks)};
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (mrg->ms_shdr.sh_type != SHT_NOBITS) {
+            bh.bh_base = bh.bh_pos;
+            visit_section(mrg, hash_chunk, &bh);
+            hash_append(&bh, NULL, bh.bh_base + mrg->ms_memsz - bh.bh_pos);
+        }
+    }
+
+    if (bh.bh_len != 0 || bh.bh_pos == 0) {
+        hash_flush(&bh);
+    }
+
+    build_id_digest(kind, bh.bh_digests, nblocks * size, desc);
+    free(bh.bh_digests);
+    free(bh.bh_data);
+}
+
+/**
+ * @brief Leaves the merged sections at the end of each segment whose contents
+ * are all zeros, after relocation, out of its file size, since loaders
+ * zero-fill the rest of the memory size anyway. Those sections become
+ * SHT_NOBITS, so that every file-backed section stays entirely inside the file
+ * size of its segment, as tools mapping sections to segments expect. Startup
+ * code that copies segments or checks their CRC relies on their file contents,
+ * so this is skipped when a copy table or an image CRC is requested
+ */
+static void trim_segments(void) {
+    for (size_t i = 0; i < g_self->i_segs.len; i++) {
+        ezld_out_seg_t *seg = &g_self->i_segs.buf[i];
+
+        for (size_t j = seg->sg_mss.len; j > 0 && seg->sg_filesz != 0; j--) {
+            ezld_mrg_sec_t *mrg = seg->sg_mss.buf[j - 1];
+
+            if (mrg->ms_shdr.sh_type == SHT_NOBITS) {
+                continue;
+            }
+
+            uint8_t *buf  = section_image(mrg);
+            bool     zero = is_zero(buf, mrg->ms_memsz);
+            free(buf);
+
+            if (!zero) {
+                seg->sg_filesz = mrg->ms_vaddr - seg->sg_vaddr + mrg->ms_memsz;
+                break;
+            }
+
+            mrg->ms_shdr.sh_type = SHT_NOBITS;
+            seg->sg_filesz       = mrg->ms_vaddr - seg->sg_vaddr;
+        }
+    }
+}
+
+/**
+ * @brief Writes the output as a relocatable object file, which holds the merged
+ * sections, a symbol table with the symbols of all object files, and their
+ * relocations rewritten to apply to the merged sections. This replaces
+ * `write_exec` and `apply_relocations` when doing a partial link
+ */
+static void write_rel(void) {
+    Elf32_Ehdr        ehdr  = new_ehdr(ET_REL);
+    ezld_shdrs_t      shdrs = ezld_array_new();
+    ezld_out_symtab_t symtab;
+
+    size_t num_secs = number_sections();
+    build_symtab(&symtab, true);
+    collect_relocs(true);
+
+    // Merged sections come first, so that their index is `ms_outndx`
+    size_t off              = sizeof(Elf32_Ehdr);
+    *ezld_array_push(shdrs) = (Elf32_Shdr){0};
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (mrg->ms_outndx == 0) {
+            continue;
+        }
+
+        Elf32_Shdr shdr = mrg->ms_shdr;
+        shdr.sh_name    = shstr_from_idx(mrg->ms_name).gs_offset;
+        shdr.sh_size    = mrg->ms_memsz;
+        shdr.sh_offset  = align_up(off, shdr.sh_addralign);
+        (void)write_segment(mrg,
+                            shdr.sh_offset,
+                            g_self->i_cfg.cfg_outpath,
+                            g_self->i_out.out_file);
+
+        if (shdr.sh_type != SHT_NOBITS) {
+            off = shdr.sh_offset + shdr.sh_size;
+        }
+
+        *ezld_array_push(shdrs) = endian_shdr(shdr);
+    }
+
+    off = write_symtab_relas(&symtab, off, num_secs + 1, &shdrs);
+    ezld_runtime_seek(off, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+    ehdr.e_shstrndx         = shdrs.len;
+    *ezld_array_push(shdrs) = write_strtab(".shstrtab", &g_self->i_shstrtab);
+
+    ehdr.e_shoff = align_up(ftell(g_self->i_out.out_file), 4);
+    ehdr.e_shnum = shdrs.len;
+    ezld_runtime_write_exact_at(shdrs.buf,
+                                shdrs.len * sizeof(Elf32_Shdr),
+                                ehdr.e_shoff,
+                                g_self->i_cfg.cfg_outpath,
+                                g_self->i_out.out_file);
+
+    ehdr = endian_ehdr(ehdr);
+    ezld_runtime_write_exact_at(&ehdr,
+                                sizeof(Elf32_Ehdr),
+                                0,
+                                g_self->i_cfg.cfg_outpath,
+                                g_self->i_out.out_file);
+
+    ezld_array_free(shdrs);
+    ezld_array_free(symtab.ot_syms);
+    ezld_array_free(symtab.ot_strs);
+}
+
+/**
+ * @return the rank of a merged section in the output: code comes first, then
+ * read-only data, then writable data, and zero-initialized data last, so that
+ * sections with the same permissions end up next to each other
+ */
+static size_t section_class(ezld_mrg_sec_t *mrg) {
+    if (mrg->ms_shdr.sh_flags & SHF_WRITE) {
+        return (mrg->ms_shdr.sh_type == SHT_NOBITS) ? 3 : 2;
+    }
+
+    return (mrg->ms_shdr.sh_flags & SHF_EXECINSTR) ? 0 : 1;
+}
+
+/**
+ * @brief qsort comparator for pointers to merged sections, sorting by
+ * `section_class` first and by `ms_ndx` then
+ */
+static int compare_mrg_classes(const void *a, const void *b) {
+    ezld_mrg_sec_t *ma = *(ezld_mrg_sec_t *const *)a;
+    ezld_mrg_sec_t *mb = *(ezld_mrg_sec_t *const *)b;
+    size_t          ca = section_class(ma);
+    size_t          cb = section_class(mb);
+
+    if (ca != cb) {
+        return (ca < cb) ? -1 : 1;
+    }
+
+    return (ma->ms_ndx > mb->ms_ndx) - (ma->ms_ndx < mb->ms_ndx);
+}
 
-        if (!ezld_array_is_empty(s->ms_oss)) {
-            Elf32_Shdr shdr = ezld_array_first(s->ms_oss)->os_shdr;
-            shdr.sh_size    = s->ms_memsz;
-            shdr.sh_name    = shstr_from_idx(s->ms_name).gs_offset;
-            shdr.sh_addr    = s->ms_vaddr;
-            shdr.sh_offset  = s->ms_fileoff;
-            shdr            = endian_shdr(shdr);
-            ezld_runtime_write_exact(&shdr,
-                                     sizeof(Elf32_Shdr),
-                                     g_self->i_cfg.cfg_outpath,
-                                     g_self->i_out.out_file);
-            ehdr.e_shnum++;
-        }
+/**
+ * @return the PF_* flags of the segment in which a merged section is loaded
+ */
+static uint32_t segment_flags(ezld_mrg_sec_t *mrg) {
+    uint32_t flags = PF_R;
+
+    if (mrg->ms_shdr.sh_flags & SHF_WRITE) {
+        flags |= PF_W;
     }
 
-    ezld_runtime_write_exact(&strtab_shdr,
-                             sizeof(Elf32_Shdr),
-                             g_self->i_cfg.cfg_outpath,
-                             g_self->i_out.out_file);
-    ezld_runtime_write_exact(&shstrtab_shdr,
-                             sizeof(Elf32_Shdr),
-                             g_self->i_cfg.cfg_outpath,
-                             g_self->i_out.out_file);
-    ehdr.e_shstrndx = ehdr.e_shnum - 1;
-    ehdr            = endian_ehdr(ehdr);
-    ezld_runtime_seek(0, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
-    ezld_runtime_write_exact(&ehdr,
-                             sizeof(Elf32_Ehdr),
-                             g_self->i_cfg.cfg_outpath,
-                             g_self->i_out.out_file);
+    if (mrg->ms_shdr.sh_flags & SHF_EXECINSTR) {
+        flags |= PF_X;
+    }
 
-    ezld_array_free(tmp_phdrs);
+    return flags;
 }
 
 /**
- * @brief Aligns all merged sections to the alignment specified by the
- * configuration
+ * @brief Assigns virtual addresses to all allocated merged sections and groups
+ * them into segments. Sections are placed by `section_class` and share a
+ * segment with the previous one if they have the same permissions and follow
+ * it immediately (except for alignment). Each segment starts on a new page,
+ * at an address aligned to the segment alignment specified by the
+ * configuration unless the compact layout was requested. This can run again
+ * after the layout changes, with `report` set to false so that warnings are
+ * not repeated
  */
-static void align_sections(void) {
+static void align_sections(bool report) {
+    ezld_array(ezld_mrg_sec_t *) allocd = ezld_array_new();
+
+    // Segments from a previous call are discarded
+    for (size_t i = 0; i < g_self->i_segs.len; i++) {
+        ezld_array_free(g_self->i_segs.buf[i].sg_mss);
+    }
+    g_self->i_segs.len = 0;
+
     for (size_t i = 0; i < g_self->i_mss.len; i++) {
-        ezld_mrg_sec_t *mrg      = &g_self->i_mss.buf[i];
-        const char     *sec_name = shstr_from_idx(mrg->ms_name).gs_data;
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+        mrg->ms_vaddr       = mrg->ms_reqvaddr;
 
         if (ezld_array_is_empty(mrg->ms_oss)) {
-            ezld_runtime_message(EZLD_EMSG_WARN,
-                                 "section '%s' is empty",
-                                 shstr_from_idx(mrg->ms_name).gs_data);
-            continue;
+            if (report) {
+                ezld_runtime_message(EZLD_EMSG_WARN,
+                                     "section '%s' is empty",
+                                     shstr_from_idx(mrg->ms_name).gs_data);
+            }
+        } else if (mrg->ms_shdr.sh_flags & SHF_ALLOC) {
+            *ezld_array_push(allocd) = mrg;
         }
+    }
 
-        size_t sh_align  = ezld_array_first(mrg->ms_oss)->os_shdr.sh_addralign;
-        size_t seg_align = g_self->i_cfg.cfg_segalign;
-        size_t align     = sh_align;
-        if (ezld_array_first(mrg->ms_oss)->os_shdr.sh_flags & SHF_ALLOC &&
-            seg_align > sh_align) {
-            align = seg_align;
+    if (allocd.len > 1) {
+        qsort(allocd.buf,
+              allocd.len,
+              sizeof(ezld_mrg_sec_t *),
+              compare_mrg_classes);
+    }
+
+    ezld_out_seg_t *seg    = NULL;
+    size_t          cursor = 0;
+    for (size_t i = 0; i < allocd.len; i++) {
+        ezld_mrg_sec_t *mrg      = allocd.buf[i];
+        const char     *sec_name = shstr_from_idx(mrg->ms_name).gs_data;
+        uint32_t        flags    = segment_flags(mrg);
+        bool            nobits   = mrg->ms_shdr.sh_type == SHT_NOBITS;
+        size_t          align    = mrg->ms_shdr.sh_addralign;
+
+        if (align == 0) {
+            align = 1;
         }
-        mrg->ms_memsz = mrg->ms_memsz + (align - (mrg->ms_memsz % align));
 
-        if (!(ezld_array_first(mrg->ms_oss)->os_shdr.sh_flags & SHF_ALLOC)) {
-            continue;
+        // The copy and zero tables describe whole words, so the sections they
+        // refer to must start on a word boundary
+        if (g_self->i_copytable != NULL && align < 4 &&
+            (nobits || mrg->ms_reqpaddr != 0)) {
+            align = 4;
         }
 
-        if (i > 0) {
-            ezld_mrg_sec_t *prev_mrg = &g_self->i_mss.buf[i - 1];
+        // Sections with a fixed address only join the previous segment if
+        // they happen to be right after it, and file-backed sections can not
+        // follow zero-initialized ones in the same segment. Sections with a
+        // load address always start a new segment
+        bool new_seg = seg == NULL || flags != seg->sg_flags ||
+                       (seg->sg_filesz < seg->sg_memsz && !nobits) ||
+                       (mrg->ms_reqvaddr != 0 &&
+                        mrg->ms_reqvaddr != align_up(cursor, align)) ||
+                       mrg->ms_reqpaddr != 0;
+
+        size_t seg_align = g_self->i_cfg.cfg_segalign;
+        size_t start     = align_up(cursor, align);
+
+        // In compact mode, a new segment goes to the next page but keeps the
+        // offset in the page, so that it can follow the previous segment in
+        // the file without padding
+        if (new_seg && g_self->i_cfg.cfg_compact) {
+            if (seg != NULL && seg_align > 1 && cursor % seg_align != 0) {
+                start = align_up(cursor + seg_align, align);
+            }
+        } else if (new_seg && seg_align > align) {
+            align = seg_align;
+            start = align_up(cursor, align);
+        }
 
-            if (mrg->ms_vaddr < prev_mrg->ms_vaddr + prev_mrg->ms_memsz) {
-                size_t diff =
-                    prev_mrg->ms_vaddr + prev_mrg->ms_memsz - mrg->ms_vaddr;
-                size_t old_virt = mrg->ms_vaddr;
-                mrg->ms_vaddr += diff;
+        if (mrg->ms_vaddr == 0) {
+            mrg->ms_vaddr = start;
+        }
 
+        if (seg != NULL && mrg->ms_vaddr < cursor) {
+            if (report) {
                 ezld_runtime_message(EZLD_EMSG_WARN,
                                      "section '%s' has overlapping virtual "
                                      "address 0x%08x, changing to 0x%08x",
                                      sec_name,
-                                     old_virt,
-                                     mrg->ms_vaddr);
+                                     mrg->ms_vaddr,
+                                     cursor);
             }
+            mrg->ms_vaddr = cursor;
         }
 
         if (mrg->ms_vaddr == 0) {
-            ezld_runtime_message(EZLD_EMSG_WARN,
-                                 "section '%s' has virtual address 0x%08x",
-                                 sec_name,
-                                 0);
+            if (report) {
+                ezld_runtime_message(EZLD_EMSG_WARN,
+                                     "section '%s' has virtual address 0x%08x",
+                                     sec_name,
+                                     0);
+            }
         } else if (mrg->ms_vaddr % align != 0) {
-            size_t aligned_virt =
-                mrg->ms_vaddr + (align - (mrg->ms_vaddr % align));
-            ezld_runtime_message(
-                EZLD_EMSG_WARN,
-                "section '%s' has misaligned virtual address 0x%08x (requires "
-                "alignment of %u byte(s)), changing to 0x%08x",
-                sec_name,
-                mrg->ms_vaddr,
-                align,
-                aligned_virt);
+            size_t aligned_virt = align_up(mrg->ms_vaddr, align);
+            if (report) {
+                ezld_runtime_message(EZLD_EMSG_WARN,
+                                     "section '%s' has misaligned virtual "
+                                     "address 0x%08x (requires alignment of "
+                                     "%u byte(s)), changing to 0x%08x",
+                                     sec_name,
+                                     mrg->ms_vaddr,
+                                     align,
+                                     aligned_virt);
+            }
             mrg->ms_vaddr = aligned_virt;
         }
+
+        if (new_seg) {
+            seg            = ezld_array_push(g_self->i_segs);
+            seg->sg_vaddr  = mrg->ms_vaddr;
+            seg->sg_paddr  = (mrg->ms_reqpaddr != 0) ? mrg->ms_reqpaddr
+                                                     : mrg->ms_vaddr;
+            seg->sg_memsz  = 0;
+            seg->sg_filesz = 0;
+            seg->sg_flags  = flags;
+            ezld_array_init(seg->sg_mss);
+        }
+
+        *ezld_array_push(seg->sg_mss) = mrg;
+        mrg->ms_paddr = seg->sg_paddr + (mrg->ms_vaddr - seg->sg_vaddr);
+        seg->sg_memsz = mrg->ms_vaddr + mrg->ms_memsz - seg->sg_vaddr;
+        if (!nobits) {
+            seg->sg_filesz = seg->sg_memsz;
+        }
+
+        cursor = mrg->ms_vaddr + mrg->ms_memsz;
+    }
+
+    ezld_array_free(allocd);
+}
+
+/**
+ * @brief Translates all symbol virtual addresses by adding the relative
+ * section's virtual address. This is used because object files store offsets in
+ * symbol table, whereas final executables include the real virtual address
+ */
+void virtualize_syms(void) {
+    for (size_t i = 0; i < g_self->i_globsymtab.len; i++) {
+        ezld_glob_sym_t *gsym = &g_self->i_globsymtab.buf[i];
+        Elf32_Sym       *sym  = &gsym->gsy_esym;
+        sym->st_value         = gsym->gsy_os->os_mrg->ms_vaddr +
+                        translate_off(gsym->gsy_os, gsym->gsy_off);
+    }
+}
+
+/**
+ * @brief Defines a global symbol in a section created by the linker. References
+ * to the symbol from object files are resolved by name like any other
+ *
+ * @param name the name of the symbol, which must outlive the instance
+ * @param os the synthetic section, which must be part of a merged section
+ * @param off the offset of the symbol in `os`
+ */
+static void define_sym(const char *name, ezld_obj_sec_t *os, size_t off) {
+    size_t glob_strndx = globstr_add(name);
+
+    if (resolve_sym(NULL, NULL, glob_strndx, false) != EZLD_GLOB_SYM_UNDEF) {
+        ezld_runtime_exit(
+            EZLD_ECODE_BADSYM, "multiple definitions of symbol '%s'", name);
+    }
+
+    ezld_glob_sym_t *gsym = ezld_array_push(g_self->i_globsymtab);
+    gsym->gsy_os          = os;
+    gsym->gsy_off         = off;
+    gsym->gsy_esym =
+        (Elf32_Sym){.st_name  = glob_strndx,
+                    .st_value = off,
+                    .st_info  = ELF32_ST_INFO(STB_GLOBAL, STT_OBJECT),
+                    .st_shndx = os->os_mrg->ms_ndx};
+}
+
+/**
+ * @return the hash of a symbol name used by GNU-style hash tables
+ */
+static uint32_t symhash_hash(const char *name) {
+    uint32_t h = 5381;
+
+    for (const unsigned char *c = (const unsigned char *)name; *c != '\0';
+         c++) {
+        h = h * 33 + *c;
+    }
+
+    return h;
+}
+
+/**
+ * @brief Computes the dimensions of a symbol hash table
+ *
+ * @param nsyms the number of symbols in the table
+ * @param nbuckets where the number of buckets is stored
+ * @param nbloom where the number of Bloom filter words is stored
+ */
+static void symhash_dims(size_t nsyms, size_t *nbuckets, size_t *nbloom) {
+    *nbuckets = (nsyms / 4 > 1) ? nsyms / 4 : 1;
+    *nbloom   = 1;
+
+    // The number of words is a power of two, so that the word can be selected
+    // with a mask
+    while (*nbloom * 32 < nsyms * EZLD_SYMHASH_BLOOM_BITS) {
+        *nbloom <<= 1;
+    }
+}
+
+/**
+ * @brief Creates the symbol hash section, if requested, and the symbols that
+ * point into it. Its size only depends on the names of the global symbols, so
+ * it can be created before the layout, whereas its contents are filled in by
+ * `write_symhash` once addresses are known
+ */
+static void setup_symhash(void) {
+    if (!g_self->i_cfg.cfg_symhash || g_self->i_cfg.cfg_relocatable) {
+        return;
+    }
+
+    // The symbols defined here are not part of the table
+    size_t nsyms   = g_self->i_globsymtab.len;
+    size_t strs_sz = 1;
+    size_t nbuckets;
+    size_t nbloom;
+    symhash_dims(nsyms, &nbuckets, &nbloom);
+
+    for (size_t i = 0; i < nsyms; i++) {
+        Elf32_Sym esym = g_self->i_globsymtab.buf[i].gsy_esym;
+        strs_sz += globstr_from_idx(esym.st_name).gs_len + 1;
+    }
+
+    size_t syms_off = sizeof(Elf32_Word) * (4 + nbloom + nbuckets + nsyms);
+    size_t strs_off = syms_off + (nsyms + 1) * sizeof(Elf32_Sym);
+
+    Elf32_Shdr shdr   = {0};
+    shdr.sh_type      = SHT_PROGBITS;
+    shdr.sh_flags     = SHF_ALLOC;
+    shdr.sh_addralign = 4;
+    shdr.sh_size      = strs_off + strs_sz;
+
+    ezld_obj_sec_t *synth = new_synth_section(".symhash", shdr);
+    synth->os_data        = ezld_runtime_alloc(1, shdr.sh_size);
+    g_self->i_symhash     = synth;
+    g_self->i_symhashlen  = nsyms;
+    merge_section(synth);
+
+    define_sym("__symhash", synth, 0);
+    define_sym("__symhash_syms", synth, syms_off);
+    define_sym("__symhash_strs", synth, strs_off);
+}
+
+/**
+ * @brief qsort comparator for symbol hash entries, sorting by bucket first and
+ * by index in the global symbol table then
+ */
+static int compare_symhash(const void *a, const void *b) {
+    const ezld_symhash_ent_t *ea = a;
+    const ezld_symhash_ent_t *eb = b;
+
+    if (ea->she_bucket != eb->she_bucket) {
+        return (ea->she_bucket < eb->she_bucket) ? -1 : 1;
+    }
+
+    return (ea->she_ndx > eb->she_ndx) - (ea->she_ndx < eb->she_ndx);
+}
+
+/**
+ * @brief Fills in the symbol hash section created by `setup_symhash`. The
+ * section holds, in order:
+ * - a GNU hash table (`nbuckets`, `symoffset` = 1, `bloom_size`, `bloom_shift`,
+ *   the Bloom filter words, the buckets, and the chains)
+ * - the symbols it indexes, as ELF symbol table entries starting with a null
+ *   entry (`__symhash_syms`)
+ * - their names (`__symhash_strs`), which `st_name` is relative to
+ * All words are in the byte order of the output
+ */
+static void write_symhash(void) {
+    ezld_obj_sec_t *synth = g_self->i_symhash;
+
+    if (synth == NULL) {
+        return;
+    }
+
+    size_t    nsyms = g_self->i_symhashlen;
+    uint32_t *words = (uint32_t *)synth->os_data;
+    size_t    nbuckets;
+    size_t    nbloom;
+    symhash_dims(nsyms, &nbuckets, &nbloom);
+
+    uint32_t  *bloom    = &words[4];
+    uint32_t  *buckets  = &bloom[nbloom];
+    uint32_t  *chains   = &buckets[nbuckets];
+    Elf32_Sym *syms     = (Elf32_Sym *)&chains[nsyms];
+    char      *strs     = (char *)&syms[nsyms + 1];
+    size_t     strs_off = 1;
+
+    ezld_symhash_ent_t *ents =
+        ezld_runtime_alloc(nsyms ? nsyms : 1, sizeof(ezld_symhash_ent_t));
+    for (size_t i = 0; i < nsyms; i++) {
+        Elf32_Sym   esym   = g_self->i_globsymtab.buf[i].gsy_esym;
+        const char *name   = globstr_from_idx(esym.st_name).gs_data;
+        ents[i].she_hash   = symhash_hash(name);
+        ents[i].she_bucket = ents[i].she_hash % nbuckets;
+        ents[i].she_ndx    = i;
+    }
+
+    qsort(ents, nsyms, sizeof(ezld_symhash_ent_t), compare_symhash);
+    (void)number_sections();
+    memset(synth->os_data, 0, synth->os_shdr.sh_size);
+    words[0] = endian32(nbuckets);
+    words[1] = endian32(1);
+    words[2] = endian32(nbloom);
+    words[3] = endian32(EZLD_SYMHASH_BLOOM_SHIFT);
+
+    for (size_t i = 0; i < nsyms; i++) {
+        ezld_symhash_ent_t *ent  = &ents[i];
+        ezld_glob_sym_t    *gsym = &g_self->i_globsymtab.buf[ent->she_ndx];
+        ezld_glob_str_t     name = globstr_from_idx(gsym->gsy_esym.st_name);
+        uint32_t            h    = ent->she_hash;
+        uint32_t           *word = &bloom[(h / 32) & (nbloom - 1)];
+
+        *word = endian32(endian32(*word) | (1u << (h % 32)) |
+                         (1u << ((h >> EZLD_SYMHASH_BLOOM_SHIFT) % 32)));
+
+        if (i == 0 || ents[i - 1].she_bucket != ent->she_bucket) {
+            buckets[ent->she_bucket] = endian32(i + 1);
+        }
+
+        bool last = i + 1 == nsyms || ents[i + 1].she_bucket != ent->she_bucket;
+        chains[i] = endian32((h & ~1u) | (last ? 1 : 0));
+
+        Elf32_Sym sym = gsym->gsy_esym;
+        sym.st_name   = strs_off;
+        sym.st_shndx  = gsym->gsy_os->os_mrg->ms_outndx;
+        syms[i + 1]   = endian_sym(sym);
+        memcpy(&strs[strs_off], name.gs_data, name.gs_len + 1);
+        strs_off += name.gs_len + 1;
+    }
+
+    free(ents);
+}
+
+/**
+ * @brief Creates the section holding the copy and zero tables if a load
+ * address was requested for any section. The copy table has a (source,
+ * destination, length) entry for each section with a load address and the
+ * file-backed sections that follow it in its segment, and the zero table has a
+ * (destination, length) entry for each SHT_NOBITS section. Entries are made of
+ * 32-bit words, and lengths are rounded up to whole words so that startup code
+ * can copy and clear word by word. The tables are delimited by the
+ * `__copy_table_start`, `__copy_table_end`, `__zero_table_start`, and
+ * `__zero_table_end` symbols, and are filled by `write_copytable`
+ */
+static void setup_copytable(void) {
+    if (ezld_array_is_empty(g_self->i_cfg.cfg_loadaddrs) ||
+        g_self->i_cfg.cfg_relocatable) {
+        return;
+    }
+
+    size_t ncopies = 0;
+    size_t nzeros  = 0;
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (ezld_array_is_empty(mrg->ms_oss) ||
+            !(mrg->ms_shdr.sh_flags & SHF_ALLOC)) {
+            continue;
+        }
+
+        if (mrg->ms_shdr.sh_type == SHT_NOBITS) {
+            nzeros++;
+        } else if (mrg->ms_reqpaddr != 0) {
+            ncopies++;
+        }
+    }
+
+    size_t zero_off = ncopies * 3 * sizeof(uint32_t);
+
+    Elf32_Shdr shdr   = {0};
+    shdr.sh_type      = SHT_PROGBITS;
+    shdr.sh_flags     = SHF_ALLOC;
+    shdr.sh_addralign = 4;
+    shdr.sh_size      = zero_off + nzeros * 2 * sizeof(uint32_t);
+
+    ezld_obj_sec_t *synth = new_synth_section(".copytable", shdr);
+    synth->os_data        = ezld_runtime_alloc(1, shdr.sh_size + 1);
+    g_self->i_copytable   = synth;
+    g_self->i_ncopies     = ncopies;
+    merge_section(synth);
+
+    define_sym("__copy_table_start", synth, 0);
+    define_sym("__copy_table_end", synth, zero_off);
+    define_sym("__zero_table_start", synth, zero_off);
+    define_sym("__zero_table_end", synth, shdr.sh_size);
+}
+
+/**
+ * @brief Makes sure that rounding a range of memory up to whole words does not
+ * make it spill into another section
+ *
+ * @param start the start address of the range
+ * @param end the end address of the range
+ * @param what a description of the range for error messages
+ *
+ * @return the rounded length of the range
+ */
+static uint32_t word_range(size_t start, size_t end, const char *what) {
+    size_t rounded = align_up(end, 4);
+
+    for (size_t i = 0; i < g_self->i_mss.len; i++) {
+        ezld_mrg_sec_t *mrg = g_self->i_mss.buf[i];
+
+        if (!ezld_array_is_empty(mrg->ms_oss) &&
+            (mrg->ms_shdr.sh_flags & SHF_ALLOC) && mrg->ms_memsz != 0 &&
+            mrg->ms_vaddr >= end && mrg->ms_vaddr < rounded) {
+            ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                              "%s at 0x%08x does not end on a word boundary "
+                              "before section '%s'",
+                              what,
+                              start,
+                              shstr_from_idx(mrg->ms_name).gs_data);
+        }
+    }
+
+    return rounded - start;
+}
+
+/**
+ * @brief Fills the copy and zero tables created by `setup_copytable` once
+ * addresses are final, and checks that the load addresses of segments do not
+ * overlap
+ */
+static void write_copytable(void) {
+    ezld_obj_sec_t *synth = g_self->i_copytable;
+    size_t          copy  = 0;
+    size_t          zero  = g_self->i_ncopies * 3 * sizeof(uint32_t);
+
+    if (synth == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < g_self->i_segs.len; i++) {
+        ezld_out_seg_t *seg = &g_self->i_segs.buf[i];
+
+        for (size_t j = 0; j < g_self->i_segs.len; j++) {
+            ezld_out_seg_t *other = &g_self->i_segs.buf[j];
+
+            if (i != j && seg->sg_filesz != 0 && other->sg_filesz != 0 &&
+                seg->sg_paddr < other->sg_paddr + other->sg_filesz &&
+                other->sg_paddr < seg->sg_paddr + seg->sg_filesz) {
+                ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                                  "segment loaded at 0x%08x overlaps segment "
+                                  "loaded at 0x%08x",
+                                  seg->sg_paddr,
+                                  other->sg_paddr);
+            }
+        }
+
+        for (size_t j = 0; j < seg->sg_mss.len; j++) {
+            ezld_mrg_sec_t *mrg = seg->sg_mss.buf[j];
+
+            if (mrg->ms_shdr.sh_type == SHT_NOBITS) {
+                uint32_t ent[2] = {
+                    endian32(mrg->ms_vaddr),
+                    endian32(word_range(mrg->ms_vaddr,
+                                        mrg->ms_vaddr + mrg->ms_memsz,
+                                        "zero-initialized section"))};
+                memcpy(&synth->os_data[zero], ent, sizeof ent);
+                zero += sizeof ent;
+            } else if (mrg->ms_reqpaddr != 0) {
+                // The section starts the segment, whose file-backed part is
+                // copied as a whole
+                uint32_t ent[3] = {
+                    endian32(mrg->ms_paddr),
+                    endian32(mrg->ms_vaddr),
+                    endian32(word_range(mrg->ms_vaddr,
+                                        seg->sg_vaddr + seg->sg_filesz,
+                                        "copied segment"))};
+                memcpy(&synth->os_data[copy], ent, sizeof ent);
+                copy += sizeof ent;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Tells whether a relocation refers to an absolute value, which does
+ * not move along with the image. This is the case of symbols in SHN_ABS and of
+ * undefined (weak) symbols, which resolve to zero
+ *
+ * @param sym the symbol referenced by the relocation
+ *
+ * @return `true` if the symbol is absolute, `false` otherwise
+ */
+static bool reloc_is_absolute(ezld_obj_sym_t *sym) {
+    Elf32_Sym esym = sym->osy_esym;
+
+    if (ELF32_ST_BIND(esym.st_info) == STB_LOCAL &&
+        esym.st_shndx != SHN_UNDEF) {
+        return esym.st_shndx == SHN_ABS;
+    }
+
+    return resolve_sym(NULL, sym, 0, true) == EZLD_GLOB_SYM_UNDEF;
+}
+
+/**
+ * @brief Creates the `.dynamic` and `.relr.dyn` sections of a static PIE, and
+ * records the places of all R_RISCV_32 relocations against symbols that move
+ * along with the image, which have to be relocated again by the startup code
+ * once the load address is known. The dynamic section is found through the
+ * `_DYNAMIC` symbol, and is filled by `write_dynamic`
+ */
+static void setup_dynamic(void) {
+    if (!g_self->i_cfg.cfg_staticpie || g_self->i_cfg.cfg_relocatable) {
+        return;
+    }
+
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+        for (size_t j = 0; j < obj->obj_oss.len; j++) {
+            ezld_obj_sec_t *rela = &obj->obj_oss.buf[j];
+
+            if (rela->os_shdr.sh_type != SHT_RELA || rela->os_discarded ||
+                rela->os_shdr.sh_info >= obj->obj_oss.len) {
+                continue;
+            }
+
+            // Sections that are not loaded, such as debugging information,
+            // keep link-time addresses
+            ezld_obj_sec_t *target = &obj->obj_oss.buf[rela->os_shdr.sh_info];
+            if (target->os_mrg == NULL || target->os_mrgsyn != NULL ||
+                !(target->os_mrg->ms_shdr.sh_flags & SHF_ALLOC)) {
+                continue;
+            }
+
+            read_section_contents(rela);
+            Elf32_Rela *relas = (Elf32_Rela *)rela->os_data;
+            size_t      num   = rela->os_shdr.sh_size / sizeof(Elf32_Rela);
+
+            for (size_t k = 0; k < num; k++) {
+                size_t sym_idx = ELF32_R_SYM(relas[k].r_info);
+
+                if (ELF32_R_TYPE(relas[k].r_info) != R_RISCV_32 ||
+                    sym_idx >= obj->obj_ost.ost_syms.len ||
+                    reloc_is_absolute(&obj->obj_ost.ost_syms.buf[sym_idx])) {
+                    continue;
+                }
+
+                ezld_reloc_site_t *site = ezld_array_push(g_self->i_relrs);
+                site->rs_os             = target;
+                site->rs_off            = relas[k].r_offset;
+            }
+        }
+    }
+
+    Elf32_Shdr shdr   = {0};
+    shdr.sh_type      = SHT_DYNAMIC;
+    shdr.sh_flags     = SHF_ALLOC | SHF_WRITE;
+    shdr.sh_addralign = 4;
+    shdr.sh_entsize   = sizeof(Elf32_Dyn);
+    shdr.sh_size      = EZLD_DYNAMIC_ENTRIES * sizeof(Elf32_Dyn);
+
+    ezld_obj_sec_t *dynamic = new_synth_section(".dynamic", shdr);
+    dynamic->os_data        = ezld_runtime_alloc(1, shdr.sh_size);
+    g_self->i_dynamic       = dynamic;
+    merge_section(dynamic);
+    dynamic->os_mrg->ms_shdr.sh_entsize = shdr.sh_entsize;
+
+    // The size of the packed relocations depends on their addresses, so it is
+    // only known after the layout (see `size_relr`)
+    shdr.sh_type    = SHT_RELR;
+    shdr.sh_flags   = SHF_ALLOC;
+    shdr.sh_entsize = sizeof(Elf32_Word);
+    shdr.sh_size    = 0;
+
+    ezld_obj_sec_t *relrdyn = new_synth_section(".relr.dyn", shdr);
+    g_self->i_relrdyn       = relrdyn;
+    merge_section(relrdyn);
+    relrdyn->os_mrg->ms_shdr.sh_entsize = shdr.sh_entsize;
+
+    define_sym("_DYNAMIC", dynamic, 0);
+}
+
+static int compare_addrs(const void *a, const void *b) {
+    uint32_t addr_a = *(const uint32_t *)a;
+    uint32_t addr_b = *(const uint32_t *)b;
+    return (addr_a > addr_b) - (addr_a < addr_b);
+}
+
+/**
+ * @brief Packs the relative relocations of a static PIE in the RELR format
+ * with the current layout. Each address entry (even) relocates a word and is
+ * followed by bitmap entries (odd) whose bits 1 to 31 relocate the 31 words
+ * that come after those covered by the previous entry
+ *
+ * @param out where to store the entries, or `NULL` to only count them
+ *
+ * @return the number of entries
+ */
+static size_t encode_relr(uint32_t *out) {
+    size_t    num   = g_self->i_relrs.len;
+    size_t    n     = 0;
+    uint32_t *addrs = ezld_runtime_alloc(sizeof(uint32_t), num + 1);
+
+    for (size_t i = 0; i < num; i++) {
+        ezld_reloc_site_t site = g_self->i_relrs.buf[i];
+        addrs[i] = site.rs_os->os_mrg->ms_vaddr + site.rs_os->os_transl +
+                   site.rs_off;
+    }
+
+    qsort(addrs, num, sizeof(uint32_t), compare_addrs);
+
+    for (size_t i = 0; i < num;) {
+        uint32_t base = addrs[i++];
+
+        if (out != NULL) {
+            out[n] = endian32(base);
+        }
+        n++;
+
+        for (base += 4;; base += 31 * 4) {
+            uint32_t bitmap = 0;
+
+            for (; i < num && addrs[i] < base + 31 * 4; i++) {
+                // Duplicates are already covered
+                if (addrs[i] >= base) {
+                    bitmap |= 1u << ((addrs[i] - base) / 4);
+                }
+            }
+
+            if (bitmap == 0) {
+                break;
+            }
+
+            if (out != NULL) {
+                out[n] = endian32((bitmap << 1) | 1);
+            }
+            n++;
+        }
+    }
+
+    free(addrs);
+    return n;
+}
+
+/**
+ * @brief Grows the `.relr.dyn` section of a static PIE if the relocations
+ * packed with the current layout do not fit. The section never shrinks, so
+ * that repeating the layout is bound to converge
+ *
+ * @return `true` if the section grew, in which case the layout must be
+ * computed again
+ */
+static bool size_relr(void) {
+    ezld_obj_sec_t *relrdyn = g_self->i_relrdyn;
+
+    if (relrdyn == NULL) {
+        return false;
+    }
+
+    size_t size = encode_relr(NULL) * sizeof(uint32_t);
+
+    if (size <= relrdyn->os_shdr.sh_size) {
+        return false;
+    }
+
+    relrdyn->os_shdr.sh_size = size;
+    relrdyn->os_elems        = size;
+    return true;
+}
+
+/**
+ * @brief Fills the `.relr.dyn` and `.dynamic` sections of a static PIE once
+ * addresses are final
+ */
+static void write_dynamic(void) {
+    ezld_obj_sec_t *relrdyn = g_self->i_relrdyn;
+    ezld_obj_sec_t *dynamic = g_self->i_dynamic;
+
+    if (dynamic == NULL) {
+        return;
+    }
+
+    for (size_t i = 0; i < g_self->i_relrs.len; i++) {
+        ezld_reloc_site_t site = g_self->i_relrs.buf[i];
+
+        if ((site.rs_os->os_transl + site.rs_off) % 4 != 0 ||
+            site.rs_os->os_mrg->ms_vaddr % 4 != 0) {
+            ezld_runtime_exit(EZLD_ECODE_BADSEC,
+                              "relative relocation at %s+0x%zx in '%s' is "
+                              "not aligned to 4 bytes",
+                              shstr_from_idx(site.rs_os->os_name).gs_data,
+                              site.rs_off,
+                              site.rs_os->os_obj->obj_filepath);
+        }
     }
-}
 
-/**
- * @brief Translates all symbol virtual addresses by adding the relative
- * section's virtual address. This is used because object files store offsets in
- * symbol table, whereas final executables include the real virtual address
- */
-void virtualize_syms(void) {
-    for (size_t i = 0; i < g_self->i_globsymtab.len; i++) {
-        Elf32_Sym      *sym = &g_self->i_globsymtab.buf[i];
-        ezld_mrg_sec_t *sec = &g_self->i_mss.buf[sym->st_shndx];
-        sym->st_value += sec->ms_vaddr;
+    size_t relrsz = relrdyn->os_shdr.sh_size;
+    relrdyn->os_data = ezld_runtime_alloc(1, relrsz + 1);
+    memset(relrdyn->os_data, 0, relrsz);
+    relrsz = encode_relr((uint32_t *)relrdyn->os_data) * sizeof(uint32_t);
+
+    Elf32_Dyn dyns[EZLD_DYNAMIC_ENTRIES] = {
+        {DT_RELR, {relrdyn->os_mrg->ms_vaddr + relrdyn->os_transl}},
+        {DT_RELRSZ, {relrsz}},
+        {DT_RELRENT, {sizeof(Elf32_Word)}},
+        {DT_FLAGS_1, {DF_1_PIE}},
+        {DT_NULL, {0}}};
+
+    for (size_t i = 0; i < EZLD_DYNAMIC_ENTRIES; i++) {
+        dyns[i].d_tag      = endian32(dyns[i].d_tag);
+        dyns[i].d_un.d_val = endian32(dyns[i].d_un.d_val);
     }
+
+    memcpy(dynamic->os_data, dyns, sizeof dyns);
 }
 
 /**
@@ -1236,13 +5406,29 @@ void virtualize_syms(void) {
 static void setup_sections(void) {
     for (size_t i = 0; i < g_self->i_cfg.cfg_sections.len; i++) {
         ezld_sec_cfg_t  sec_cfg = g_self->i_cfg.cfg_sections.buf[i];
-        ezld_mrg_sec_t *mrg     = ezld_array_push(g_self->i_mss);
-        mrg->ms_ndx             = g_self->i_mss.len - 1;
+        ezld_mrg_sec_t *mrg     = new_mrg_sec(shstr_add(sec_cfg.sc_name));
         mrg->ms_vaddr           = sec_cfg.sc_vaddr;
-        mrg->ms_name            = shstr_add(sec_cfg.sc_name);
-        mrg->ms_memsz           = 0;
-        mrg->ms_fileoff         = 0;
-        ezld_array_init(mrg->ms_oss);
+        mrg->ms_reqvaddr        = sec_cfg.sc_vaddr;
+    }
+
+    for (size_t i = 0; i < g_self->i_cfg.cfg_loadaddrs.len; i++) {
+        ezld_sec_cfg_t  sec_cfg = g_self->i_cfg.cfg_loadaddrs.buf[i];
+        size_t          name    = shstr_add(sec_cfg.sc_name);
+        ezld_mrg_sec_t *mrg     = find_mrg_sec(name);
+
+        if (sec_cfg.sc_vaddr % 4 != 0) {
+            ezld_runtime_exit(EZLD_ECODE_BADPARAM,
+                              "load address 0x%08x of section '%s' is not "
+                              "aligned to 4 bytes",
+                              sec_cfg.sc_vaddr,
+                              sec_cfg.sc_name);
+        }
+
+        if (mrg == NULL) {
+            mrg = new_mrg_sec(name);
+        }
+
+        mrg->ms_reqpaddr = sec_cfg.sc_vaddr;
     }
 }
 
@@ -1280,23 +5466,49 @@ static void free_instance(void) {
     ezld_array_free(g_self->i_globstrtab.gst_strs);
     ezld_array_free(g_self->i_shstrtab.gst_strs);
 
+    for (size_t i = 0; i < g_self->i_ownedstrs.len; i++) {
+        free(g_self->i_ownedstrs.buf[i]);
+    }
+    ezld_array_free(g_self->i_ownedstrs);
+
     for (size_t i = 0; i < g_self->i_objs.len; i++) {
         ezld_obj_t *obj = &g_self->i_objs.buf[i];
         for (size_t j = 0; j < obj->obj_oss.len; j++) {
             ezld_obj_sec_t *sec = &obj->obj_oss.buf[j];
             free(sec->os_data);
             sec->os_data = NULL;
+            ezld_array_free(sec->os_pieces);
+            ezld_array_free(sec->os_drelocs);
         }
         ezld_array_free(obj->obj_oss);
         ezld_array_free(obj->obj_ost.ost_syms);
         fclose(obj->obj_file);
     }
 
+    for (size_t i = 0; i < g_self->i_synthsecs.len; i++) {
+        ezld_obj_sec_t *sec = g_self->i_synthsecs.buf[i];
+        free(sec->os_data);
+        free(sec);
+    }
+
     for (size_t i = 0; i < g_self->i_mss.len; i++) {
-        ezld_mrg_sec_t *ms = &g_self->i_mss.buf[i];
+        ezld_mrg_sec_t *ms = g_self->i_mss.buf[i];
         ezld_array_free(ms->ms_oss);
+        ezld_array_free(ms->ms_relas);
+        free(ms->ms_zdata);
+        free(ms);
     }
 
+    for (size_t i = 0; i < g_self->i_segs.len; i++) {
+        ezld_array_free(g_self->i_segs.buf[i].sg_mss);
+    }
+
+    ezld_array_free(g_self->i_segs);
+    ezld_array_free(g_self->i_synthsecs);
+    ezld_array_free(g_self->i_mrgsyns);
+    ezld_array_free(g_self->i_thunks);
+    ezld_array_free(g_self->i_relrs);
+    ezld_htab_free(&g_self->i_comdats);
     ezld_array_free(g_self->i_mss);
     ezld_array_free(g_self->i_objs);
     fclose(g_self->i_out.out_file);
@@ -1304,25 +5516,21 @@ static void free_instance(void) {
 
 // TODO: fix HUGE endianness UB here
 /**
- * @brief Applies relocations to the final executable (after it has been written
- * to disk)
+ * @brief Applies a relocation to the contents of an object file section, before
+ * they are written to the output
  *
- * @param data original data from the section (code or data) - not relocated
+ * @param data the location being relocated in the section contents
  * @param bufsz size of the data buffer
- * @param outfile_off offset in the output file where to store the relocation
  * @param type the type of relocation read from the ELF file
- * @param virt_addr the virtual address of the section (used for relative
- * values)
- * @param addend the added of the relotion
- * @param globsym global symbol table (in-memory)
- */
-static void relocate(uint8_t  *data,
-                     size_t    bufsz,
-                     size_t    outfile_off,
-                     size_t    type,
-                     size_t    virt_addr,
-                     size_t    addend,
-                     Elf32_Sym globsym) {
+ * @param virt_addr the virtual address of the location being relocated (used
+ * for relative values)
+ * @param value the value of the symbol plus the addend of the relocation
+ */
+static void relocate(uint8_t *data,
+                     size_t   bufsz,
+                     size_t   type,
+                     size_t   virt_addr,
+                     uint32_t value) {
 #define REQUIRE(bytes)                                              \
     if (bufsz < bytes) {                                            \
         ezld_runtime_message(EZLD_EMSG_ERR,                         \
@@ -1332,22 +5540,21 @@ static void relocate(uint8_t  *data,
 #define REGION(type)    *(type *)data
 #define KEEP_HI32(bits) (mask32(~(uint32_t)(0) << (32 - bits)))
 #define KEEP_LO32(bits) (~KEEP_HI32((32 - bits)))
-#define WRITE(val)                                         \
-    ezld_runtime_write_exact_at(&val,                      \
-                                sizeof val,                \
-                                outfile_off,               \
-                                g_self->i_cfg.cfg_outpath, \
-                                g_self->i_out.out_file)
-
-    ezld_runtime_seek(
-        outfile_off, g_self->i_cfg.cfg_outpath, g_self->i_out.out_file);
+#define WRITE_AT(val, delta) memcpy(data + (delta), &val, sizeof val)
+#define WRITE(val)           WRITE_AT(val, 0)
 
     switch (type) {
+    case R_RISCV_32: {
+        REQUIRE(4);
+        uint32_t word = endian32(value);
+        WRITE(word);
+        break;
+    }
+
     case R_RISCV_BRANCH: {
         REQUIRE(4);
         uint32_t inst    = REGION(uint32_t);
-        int32_t  val     = (int32_t)globsym.st_value + addend - virt_addr;
-        uint32_t uval    = (uint32_t)val;
+        uint32_t uval    = value - virt_addr;
         uint32_t imm12   = (uval >> 12) & 0x1;
         uint32_t imm10_5 = (uval >> 5) & 0x3F;
         uint32_t imm4_1  = (uval >> 1) & 0xF;
@@ -1364,8 +5571,7 @@ static void relocate(uint8_t  *data,
     case R_RISCV_JAL: {
         REQUIRE(4);
         uint32_t inst     = REGION(uint32_t);
-        int32_t  val      = (int32_t)globsym.st_value + addend - virt_addr;
-        uint32_t uval     = (uint32_t)val;
+        uint32_t uval     = value - virt_addr;
         uint32_t imm20    = (uval >> 20) & 0x1;
         uint32_t imm10_1  = (uval >> 1) & 0x3FF;
         uint32_t imm11    = (uval >> 11) & 0x1;
@@ -1379,11 +5585,31 @@ static void relocate(uint8_t  *data,
         break;
     }
 
+    case R_RISCV_CALL:
+    case R_RISCV_CALL_PLT: {
+        REQUIRE(8);
+        // auipc + jalr pair, the jalr immediate is sign-extended
+        uint32_t auipc = REGION(uint32_t);
+        uint32_t jalr  = *(uint32_t *)(data + 4);
+        uint32_t uval  = value - virt_addr;
+        auipc          = (auipc & 0x00000FFF) | ((uval + 0x800) & 0xFFFFF000);
+        jalr           = (jalr & 0x000FFFFF) | ((uval & 0xFFF) << 20);
+        WRITE(auipc);
+        WRITE_AT(jalr, 4);
+        break;
+    }
+
+    case R_RISCV_PCREL_HI20:
+        value -= virt_addr;
+        // fall through
+
     case R_RISCV_HI20: {
         REQUIRE(4);
         uint32_t inst = REGION(uint32_t);
-        inst =
-            (inst & KEEP_LO32(12)) | mask32(globsym.st_value & KEEP_HI32(20));
+        // The low 12 bits are sign-extended by the paired instruction, so the
+        // upper part has to be rounded accordingly
+        inst = (inst & KEEP_LO32(12)) |
+               mask32((value + 0x800) & KEEP_HI32(20));
         WRITE(inst);
         break;
     }
@@ -1392,7 +5618,7 @@ static void relocate(uint8_t  *data,
         REQUIRE(4);
         uint32_t inst = REGION(uint32_t);
         inst          = (inst & KEEP_LO32(20)) |
-               mask32((globsym.st_value & KEEP_LO32(12)) << 20);
+               mask32((value & KEEP_LO32(12)) << 20);
         WRITE(inst);
         break;
     }
@@ -1400,7 +5626,7 @@ static void relocate(uint8_t  *data,
     case R_RISCV_LO12_S: {
         REQUIRE(4);
         uint32_t inst    = REGION(uint32_t);
-        uint32_t uval    = globsym.st_value + addend;
+        uint32_t uval    = value;
         uint32_t imm11_5 = (uval >> 5) & 0x7F;
         uint32_t imm4_0  = uval & 0x1F;
         inst &= 0x01FFF07F;
@@ -1417,33 +5643,379 @@ static void relocate(uint8_t  *data,
 #undef REQUIRE
 #undef KEEP_HI32
 #undef KEEP_LO32
+#undef WRITE_AT
 #undef WRITE
 }
 
+/**
+ * @brief Computes the value of a relocation target, that is the virtual address
+ * of a symbol plus the addend of the relocation (S + A)
+ *
+ * @param obj the object file containing the relocation
+ * @param sym the symbol referenced by the relocation
+ * @param addend the addend of the relocation
+ * @param value where the result is stored
+ *
+ * @return `true` if the symbol could be resolved, `false` otherwise
+ */
+static bool reloc_value(ezld_obj_t     *obj,
+                        ezld_obj_sym_t *sym,
+                        int32_t         addend,
+                        uint32_t       *value) {
+    Elf32_Sym esym = sym->osy_esym;
+
+    if (ELF32_ST_BIND(esym.st_info) != STB_LOCAL ||
+        esym.st_shndx == SHN_UNDEF) {
+        Elf32_Sym glob_sym;
+        if (resolve_sym(&glob_sym, sym, 0, true) == EZLD_GLOB_SYM_UNDEF) {
+            // Undefined weak references resolve to zero
+            if (ELF32_ST_BIND(esym.st_info) == STB_WEAK) {
+                *value = addend;
+                return true;
+            }
+
+            return false;
+        }
+
+        *value = glob_sym.st_value + addend;
+        return true;
+    }
+
+    if (esym.st_shndx == SHN_ABS) {
+        *value = esym.st_value + addend;
+        return true;
+    }
+
+    if (esym.st_shndx >= obj->obj_oss.len) {
+        return false;
+    }
+
+    ezld_obj_sec_t *os = &obj->obj_oss.buf[esym.st_shndx];
+
+    if (os->os_mrg == NULL) {
+        return false;
+    }
+
+    // References to SHF_MERGE sections through the section symbol encode the
+    // referenced piece in the addend, so the addend must be translated too
+    if (os->os_mrgsyn != NULL && ELF32_ST_TYPE(esym.st_info) == STT_SECTION) {
+        *value = os->os_mrg->ms_vaddr +
+                 translate_off(os, esym.st_value + addend);
+        return true;
+    }
+
+    *value = os->os_mrg->ms_vaddr + translate_off(os, esym.st_value) + addend;
+    return true;
+}
+
+/**
+ * @param obj the object file
+ * @param sym a symbol of the object file
+ *
+ * @return `true` if the symbol is defined locally in a discarded section
+ */
+static bool sym_discarded(ezld_obj_t *obj, ezld_obj_sym_t *sym) {
+    Elf32_Sym esym = sym->osy_esym;
+
+    return ELF32_ST_BIND(esym.st_info) == STB_LOCAL &&
+           esym.st_shndx != SHN_UNDEF && esym.st_shndx < obj->obj_oss.len &&
+           obj->obj_oss.buf[esym.st_shndx].os_discarded;
+}
+
+/**
+ * @return the reach of a relocation type that is checked against the distance
+ * of its target, or 0 if the relocation type reaches the whole address space
+ */
+static int32_t thunk_reach(size_t type) {
+    switch (type) {
+    case R_RISCV_JAL:
+        return EZLD_JAL_REACH;
+    case R_RISCV_BRANCH:
+        return EZLD_BRANCH_REACH;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Tells whether the instruction patched by a relocation can be sent to a
+ * range-extension thunk. Thunks clobber t1, which the calling convention only
+ * allows at calls (`jal ra`). Branches and plain jumps must reach their target
+ * directly, since t1 may be live there
+ *
+ * @param target the section holding the instruction
+ * @param off the offset of the instruction in `target`
+ * @param type the relocation type
+ */
+static bool thunk_allowed(ezld_obj_sec_t *target, uint32_t off, size_t type) {
+    if (type != R_RISCV_JAL || target->os_shdr.sh_size < 4 ||
+        off > target->os_shdr.sh_size - 4) {
+        return false;
+    }
+
+    read_section_contents(target);
+    return ((load_word(&target->os_data[off]) >> 7) & 0x1F) == 1;
+}
+
+/**
+ * @return `true` if a relocation of a given type at address `place` can refer
+ * to address `target` directly
+ */
+static bool in_reach(size_t type, uint32_t place, uint32_t target) {
+    int32_t disp  = (int32_t)(target - place);
+    int32_t reach = thunk_reach(type);
+    return disp >= -reach && disp < reach;
+}
+
+/**
+ * @return the virtual address of a range-extension thunk
+ */
+static uint32_t thunk_addr(const ezld_thunk_t *th) {
+    ezld_obj_sec_t *island = th->th_island;
+    return island->os_mrg->ms_vaddr + island->os_transl + th->th_off;
+}
+
+/**
+ * @brief Finds a range-extension thunk jumping to `target` that can be reached
+ * by a relocation of a given type at address `place`
+ *
+ * @return the thunk, or `NULL` if there is none
+ */
+static ezld_thunk_t *find_thunk(size_t type, uint32_t place, uint32_t target) {
+    for (size_t i = 0; i < g_self->i_thunks.len; i++) {
+        ezld_thunk_t *th = &g_self->i_thunks.buf[i];
+
+        if (th->th_target == target && in_reach(type, place, thunk_addr(th))) {
+            return th;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Computes the targets of all range-extension thunks again, since they
+ * move along with the layout
+ */
+static void update_thunks(void) {
+    for (size_t i = 0; i < g_self->i_thunks.len; i++) {
+        ezld_thunk_t *th = &g_self->i_thunks.buf[i];
+        (void)reloc_value(
+            th->th_obj, th->th_sym, th->th_addend, &th->th_target);
+    }
+}
+
+/**
+ * @brief Adds range-extension thunks for all calls (R_RISCV_JAL relocations of
+ * `jal ra`) whose target is out of reach with the current layout and can not
+ * be reached through an existing thunk either. New thunks are appended to
+ * the thunk island that follows the section containing the relocation
+ *
+ * @return `true` if thunks were added, in which case the layout must be
+ * computed again
+ */
+static bool add_thunks(void) {
+    bool added = false;
+    update_thunks();
+
+    for (size_t i = 0; i < g_self->i_objs.len; i++) {
+        ezld_obj_t *obj = &g_self->i_objs.buf[i];
+
+        for (size_t j = 0; j < obj->obj_oss.len; j++) {
+            ezld_obj_sec_t *rela = &obj->obj_oss.buf[j];
+
+            if (rela->os_shdr.sh_type != SHT_RELA || rela->os_discarded ||
+                rela->os_shdr.sh_info >= obj->obj_oss.len) {
+                continue;
+            }
+
+            ezld_obj_sec_t *target = &obj->obj_oss.buf[rela->os_shdr.sh_info];
+            if (target->os_mrg == NULL || target->os_mrgsyn != NULL ||
+                !(target->os_shdr.sh_flags & SHF_EXECINSTR)) {
+                continue;
+            }
+
+            read_section_contents(rela);
+            Elf32_Rela *relas = (Elf32_Rela *)rela->os_data;
+            size_t      num   = rela->os_shdr.sh_size / sizeof(Elf32_Rela);
+
+            for (size_t k = 0; k < num; k++) {
+                size_t   type    = ELF32_R_TYPE(relas[k].r_info);
+                size_t   sym_idx = ELF32_R_SYM(relas[k].r_info);
+                uint32_t value;
+
+                if (!thunk_allowed(target, relas[k].r_offset, type) ||
+                    sym_idx >= obj->obj_ost.ost_syms.len ||
+                    !reloc_value(obj,
+                                 &obj->obj_ost.ost_syms.buf[sym_idx],
+                                 relas[k].r_addend,
+                                 &value)) {
+                    continue;
+                }
+
+                uint32_t place = target->os_mrg->ms_vaddr + target->os_transl +
+                                 relas[k].r_offset;
+                if (in_reach(type, place, value) ||
+                    find_thunk(type, place, value) != NULL) {
+                    continue;
+                }
+
+                if (target->os_island == NULL) {
+                    Elf32_Shdr shdr   = {0};
+                    shdr.sh_type      = SHT_PROGBITS;
+                    shdr.sh_flags     = SHF_ALLOC | SHF_EXECINSTR;
+                    shdr.sh_addralign = 4;
+                    target->os_island = new_synth_section(
+                        shstr_from_idx(target->os_mrg->ms_name).gs_data, shdr);
+                    target->os_island->os_mrg = target->os_mrg;
+                }
+
+                // The island follows the section, so this is where the thunk
+                // will be unless the layout before the section changes too. If
+                // even that is out of reach, there is nothing to do and the
+                // link fails when relocating
+                ezld_obj_sec_t *island = target->os_island;
+                uint32_t        addr =
+                    target->os_mrg->ms_vaddr +
+                    align_up(target->os_transl + target->os_shdr.sh_size,
+                             section_align(island)) +
+                    island->os_shdr.sh_size;
+                if (!in_reach(type, place, addr)) {
+                    continue;
+                }
+
+                ezld_thunk_t *th = ezld_array_push(g_self->i_thunks);
+                th->th_obj       = obj;
+                th->th_sym       = &obj->obj_ost.ost_syms.buf[sym_idx];
+                th->th_addend    = relas[k].r_addend;
+                th->th_target    = value;
+                th->th_island    = island;
+                th->th_off       = island->os_shdr.sh_size;
+                island->os_shdr.sh_size += EZLD_THUNK_SIZE;
+                island->os_elems = island->os_shdr.sh_size;
+                added            = true;
+            }
+        }
+    }
+
+    return added;
+}
+
+/**
+ * @brief Generates the code of all range-extension thunks. Each thunk is an
+ * `auipc t1, %pcrel_hi(target)` followed by a `jalr x0, %pcrel_lo(target)(t1)`
+ */
+static void write_thunks(void) {
+    update_thunks();
+
+    for (size_t i = 0; i < g_self->i_thunks.len; i++) {
+        ezld_thunk_t   *th     = &g_self->i_thunks.buf[i];
+        ezld_obj_sec_t *island = th->th_island;
+
+        if (island->os_data == NULL) {
+            island->os_data = ezld_runtime_alloc(1, island->os_shdr.sh_size);
+        }
+
+        uint32_t disp  = th->th_target - thunk_addr(th);
+        uint32_t auipc = 0x00000317 | ((disp + 0x800) & 0xFFFFF000);
+        uint32_t jalr  = 0x00030067 | ((disp & 0xFFF) << 20);
+        auipc          = endian32(auipc);
+        jalr           = endian32(jalr);
+        memcpy(&island->os_data[th->th_off], &auipc, sizeof auipc);
+        memcpy(&island->os_data[th->th_off + 4], &jalr, sizeof jalr);
+    }
+}
+
+/**
+ * @brief Lays out all sections and assigns them virtual addresses. Since
+ * thunks and packed relative relocations make sections larger, which may put
+ * more targets out of reach or spread relocations further apart, this is
+ * repeated until no more thunks are needed and the relocations fit
+ */
+static void layout_output(void) {
+    size_t passes = 0;
+    bool   grown;
+
+    do {
+        layout_sections();
+        align_sections(false);
+        virtualize_syms();
+        grown = add_thunks();
+        grown |= size_relr();
+    } while (passes++ < EZLD_THUNK_MAX_PASSES && grown);
+
+    // Addresses are the same as in the last pass, but warnings are only
+    // reported once they are final
+    align_sections(true);
+    write_thunks();
+}
+
 static void rela_section(ezld_obj_sec_t *objsec) {
     // TODO: handle case in which symtab is wrong
     // size_t symtab_idx = objsec->os_shdr.sh_link;
     size_t          target_idx = objsec->os_shdr.sh_info;
     ezld_obj_sec_t *target     = &objsec->os_obj->obj_oss.buf[target_idx];
-    read_section_contents(target);
+
+    if (target->os_mrg == NULL) {
+        return;
+    }
+
     const char *target_name = shstr_from_idx(target->os_mrg->ms_name).gs_data;
+
+    if (target->os_mrgsyn != NULL) {
+        ezld_runtime_message(EZLD_EMSG_ERR,
+                             "relocations in mergeable section '%s' in '%s' "
+                             "are not supported, ignoring",
+                             target_name,
+                             objsec->os_obj->obj_filepath);
+        return;
+    }
+
+    read_section_contents(target);
     size_t num_entries = objsec->os_shdr.sh_size / objsec->os_shdr.sh_entsize;
     Elf32_Rela *relas  = (Elf32_Rela *)objsec->os_data;
+    ezld_htab_t pcrel_his = ezld_htab_new();
+    uint32_t    base = target->os_mrg->ms_vaddr + target->os_transl;
+
+    // Consecutive word-sized data relocations, as found in jump tables and
+    // arrays of pointers, are collected and applied together
+    ezld_array(ezld_data_reloc_t) words = ezld_array_new();
+
+    // R_RISCV_PCREL_LO12_* relocations refer to the auipc instruction that
+    // holds the upper part, whose R_RISCV_PCREL_HI20 (or R_RISCV_GOT_HI20) is
+    // looked up by offset
+    for (size_t i = 0; i < num_entries; i++) {
+        size_t hi_type = ELF32_R_TYPE(relas[i].r_info);
+
+        if (hi_type == R_RISCV_PCREL_HI20 || hi_type == R_RISCV_GOT_HI20) {
+            size_t ndx = i;
+            (void)ezld_htab_put(&pcrel_his,
+                                &relas[i].r_offset,
+                                sizeof relas[i].r_offset,
+                                &ndx);
+        }
+    }
 
     // TODO: fix endianness here too
     for (size_t i = 0; i < num_entries; i++) {
-        Elf32_Rela entry = relas[i];
-        // off = start of merged section in executable + offset inside merged
-        // section where the original object section starts + offset into the
-        // object section where the relocation needs to be applied
-        size_t off =
-            target->os_mrg->ms_fileoff + target->os_transl + entry.r_offset;
+        Elf32_Rela      entry   = relas[i];
         size_t          sym_idx = ELF32_R_SYM(entry.r_info);
         size_t          type    = ELF32_R_TYPE(entry.r_info);
         ezld_obj_sym_t *sym = &objsec->os_obj->obj_ost.ost_syms.buf[sym_idx];
-        Elf32_Sym       glob_sym;
+        uint32_t        value;
+        uint32_t        place   = base + entry.r_offset;
 
-        if (resolve_sym(&glob_sym, sym, 0, true) == EZLD_GLOB_SYM_UNDEF) {
+        bool found = reloc_value(objsec->os_obj, sym, entry.r_addend, &value);
+
+        // Debugging information may still refer to discarded sections, whose
+        // addresses are taken to be zero
+        if (!found && !(target->os_shdr.sh_flags & SHF_ALLOC) &&
+            sym_discarded(objsec->os_obj, sym)) {
+            value = 0;
+            found = true;
+        }
+
+        if (!found) {
             ezld_runtime_message(
                 EZLD_EMSG_ERR,
                 "in %s:%s+0x%x (%s:%s+0x%lx): undefined reference to '%s'",
@@ -1457,14 +6029,250 @@ static void rela_section(ezld_obj_sec_t *objsec) {
             continue;
         }
 
-        relocate(&target->os_data[entry.r_offset],
-                 target->os_shdr.sh_size - entry.r_offset,
-                 off,
-                 type,
-                 target->os_mrg->ms_vaddr + target->os_transl + entry.r_offset,
-                 entry.r_addend,
-                 glob_sym);
+        // Targets out of reach are reached through a thunk, at calls only
+        if (thunk_reach(type) != 0 && !in_reach(type, place, value)) {
+            ezld_thunk_t *th = NULL;
+
+            if (thunk_allowed(target, entry.r_offset, type)) {
+                th = find_thunk(type, place, value);
+            }
+
+            // Leaving the instruction as it is would jump elsewhere
+            if (th == NULL) {
+                ezld_runtime_exit(
+                    EZLD_ECODE_BADSEC,
+                    "in %s:%s+0x%x (%s:%s+0x%lx): target 0x%08x of '%s' is "
+                    "out of range",
+                    objsec->os_obj->obj_filepath,
+                    target_name,
+                    entry.r_offset,
+                    g_self->i_cfg.cfg_outpath,
+                    target_name,
+                    target->os_transl + entry.r_offset,
+                    value,
+                    sym->osy_name);
+            }
+
+            value = thunk_addr(th);
+        }
+
+        // Absolute addresses in instructions can not be fixed up when a
+        // static PIE is moved
+        if (g_self->i_cfg.cfg_staticpie &&
+            (type == R_RISCV_HI20 || type == R_RISCV_LO12_I ||
+             type == R_RISCV_LO12_S) &&
+            !reloc_is_absolute(sym)) {
+            ezld_runtime_message(EZLD_EMSG_ERR,
+                                 "in %s:%s+0x%x: absolute relocation against "
+                                 "'%s' can not be used in a static PIE, "
+                                 "recompile with -fPIE",
+                                 objsec->os_obj->obj_filepath,
+                                 target_name,
+                                 entry.r_offset,
+                                 sym->osy_name);
+            continue;
+        }
+
+        // Every symbol is defined in the image, so loads of its address from
+        // the GOT are turned into computations of the address relative to the
+        // pc, and no GOT is needed. Absolute symbols can not be reached that
+        // way once a static PIE is moved
+        if (type == R_RISCV_GOT_HI20) {
+            if (g_self->i_cfg.cfg_staticpie && reloc_is_absolute(sym)) {
+                ezld_runtime_message(EZLD_EMSG_ERR,
+                                     "in %s:%s+0x%x: GOT reference to "
+                                     "absolute symbol '%s' can not be used "
+                                     "in a static PIE",
+                                     objsec->os_obj->obj_filepath,
+                                     target_name,
+                                     entry.r_offset,
+                                     sym->osy_name);
+                continue;
+            }
+
+            type = R_RISCV_PCREL_HI20;
+        }
+
+        bool got_load = false;
+        if (type == R_RISCV_PCREL_LO12_I || type == R_RISCV_PCREL_LO12_S) {
+            Elf32_Addr hi_off = value - base;
+            size_t     hi_ndx;
+            uint32_t   hi_value;
+
+            if (!ezld_htab_get(
+                    &pcrel_his, &hi_off, sizeof hi_off, &hi_ndx) ||
+                !reloc_value(
+                    objsec->os_obj,
+                    &objsec->os_obj->obj_ost.ost_syms.buf[ELF32_R_SYM(
+                        relas[hi_ndx].r_info)],
+                    relas[hi_ndx].r_addend,
+                    &hi_value)) {
+                ezld_runtime_message(EZLD_EMSG_ERR,
+                                     "in %s:%s+0x%x: no R_RISCV_PCREL_HI20 "
+                                     "relocation matches '%s', ignoring",
+                                     objsec->os_obj->obj_filepath,
+                                     target_name,
+                                     entry.r_offset,
+                                     sym->osy_name);
+                continue;
+            }
+
+            // The low part is relative to the auipc, not to this instruction
+            got_load = ELF32_R_TYPE(relas[hi_ndx].r_info) == R_RISCV_GOT_HI20;
+            value    = hi_value - value;
+            type  = (type == R_RISCV_PCREL_LO12_I) ? R_RISCV_LO12_I
+                                                   : R_RISCV_LO12_S;
+        }
+
+        // Relocations are applied to the section contents in memory, so they
+        // must not point past them
+        size_t width = data_reloc_width(type);
+        if (entry.r_offset >= target->os_shdr.sh_size ||
+            target->os_shdr.sh_size - entry.r_offset < width) {
+            ezld_runtime_message(EZLD_EMSG_ERR,
+                                 "in %s:%s+0x%x: out of bounds relocation, "
+                                 "ignoring",
+                                 objsec->os_obj->obj_filepath,
+                                 target_name,
+                                 entry.r_offset);
+            continue;
+        }
+
+        // The load from the GOT becomes `addi rd, rs1, %pcrel_lo(sym)`
+        if (got_load) {
+            uint8_t *inst = &target->os_data[entry.r_offset];
+
+            if (type != R_RISCV_LO12_I ||
+                target->os_shdr.sh_size - entry.r_offset < 4 ||
+                (load_word(inst) & 0x707F) != 0x2003) {
+                ezld_runtime_message(EZLD_EMSG_ERR,
+                                     "in %s:%s+0x%x: GOT reference to '%s' "
+                                     "is not a lw instruction, ignoring",
+                                     objsec->os_obj->obj_filepath,
+                                     target_name,
+                                     entry.r_offset,
+                                     sym->osy_name);
+                continue;
+            }
+
+            store_word(inst, (load_word(inst) & ~0x707FU) | 0x13);
+        }
+
+        ezld_data_reloc_t dr = {entry.r_offset, type, value};
+
+        if (type == R_RISCV_32 || type == R_RISCV_SET32 ||
+            type == R_RISCV_ADD32 || type == R_RISCV_SUB32) {
+            *ezld_array_push(words) = dr;
+            continue;
+        }
+
+        // Relocations of the same field must be applied in order
+        apply_word_relocs(target->os_data, words.buf, words.len);
+        words.len = 0;
+
+        if (width != 0) {
+            apply_data_relocs(target->os_data,
+                              0,
+                              target->os_shdr.sh_size,
+                              &dr,
+                              1);
+        } else {
+            relocate(&target->os_data[entry.r_offset],
+                     target->os_shdr.sh_size - entry.r_offset,
+                     type,
+                     place,
+                     value);
+        }
+    }
+
+    apply_word_relocs(target->os_data, words.buf, words.len);
+    ezld_array_free(words);
+    ezld_htab_free(&pcrel_his);
+}
+
+/**
+ * @brief Computes the values of the relocations of a debugging section. They
+ * are applied by `apply_data_relocs` as the section is written, so that the
+ * section never has to be loaded whole
+ *
+ * @param objsec the RELA section
+ */
+static void defer_relocs(ezld_obj_sec_t *objsec) {
+    ezld_obj_t     *obj    = objsec->os_obj;
+    ezld_obj_sec_t *target = &obj->obj_oss.buf[objsec->os_shdr.sh_info];
+    Elf32_Rela     *relas  = (Elf32_Rela *)objsec->os_data;
+    size_t          num    = objsec->os_shdr.sh_size / sizeof(Elf32_Rela);
+    const char     *target_name =
+        shstr_from_idx(target->os_mrg->ms_name).gs_data;
+
+    for (size_t i = 0; i < num; i++) {
+        Elf32_Rela      entry   = relas[i];
+        size_t          sym_idx = ELF32_R_SYM(entry.r_info);
+        size_t          type    = ELF32_R_TYPE(entry.r_info);
+        ezld_obj_sym_t *sym     = &obj->obj_ost.ost_syms.buf[sym_idx];
+        uint32_t        value;
+
+        if (data_reloc_width(type) == 0) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "unsupported relocation type %u in "
+                                 "debugging section, ignoring",
+                                 type);
+            continue;
+        }
+
+        // Debugging information may still refer to discarded sections, whose
+        // addresses are taken to be zero
+        if (!reloc_value(obj, sym, entry.r_addend, &value)) {
+            if (!sym_discarded(obj, sym)) {
+                ezld_runtime_message(
+                    EZLD_EMSG_ERR,
+                    "in %s:%s+0x%x (%s:%s+0x%lx): undefined reference to '%s'",
+                    obj->obj_filepath,
+                    target_name,
+                    entry.r_offset,
+                    g_self->i_cfg.cfg_outpath,
+                    target_name,
+                    target->os_transl + entry.r_offset,
+                    sym->osy_name);
+                continue;
+            }
+
+            value = 0;
+        }
+
+        if (entry.r_offset >= target->os_shdr.sh_size) {
+            ezld_runtime_message(EZLD_EMSG_ERR,
+                                 "in %s:%s+0x%x: out of bounds relocation, "
+                                 "ignoring",
+                                 obj->obj_filepath,
+                                 target_name,
+                                 entry.r_offset);
+            continue;
+        }
+
+        ezld_data_reloc_t *dr = ezld_array_push(target->os_drelocs);
+        dr->dr_off            = entry.r_offset;
+        dr->dr_type           = type;
+        dr->dr_value          = value;
     }
+
+    // Relocations are almost always sorted already, in which case this takes
+    // linear time. Relocations of the same field must keep their order
+    ezld_data_reloc_t *drs = target->os_drelocs.buf;
+    for (size_t i = 1; i < target->os_drelocs.len; i++) {
+        ezld_data_reloc_t dr = drs[i];
+        size_t            j  = i;
+
+        for (; j > 0 && drs[j - 1].dr_off > dr.dr_off; j--) {
+            drs[j] = drs[j - 1];
+        }
+
+        drs[j] = dr;
+    }
+
+    // Only the computed values are needed from now on
+    free(objsec->os_data);
+    objsec->os_data = NULL;
 }
 
 static void apply_relocations(void) {
@@ -1475,8 +6283,22 @@ static void apply_relocations(void) {
             ezld_obj_sec_t *objsec = &obj->obj_oss.buf[j];
 
             // TODO: support REL as well
-            if (objsec->os_shdr.sh_type == SHT_RELA) {
-                read_section_contents(objsec);
+            if (objsec->os_shdr.sh_type != SHT_RELA || objsec->os_discarded) {
+                continue;
+            }
+
+            read_section_contents(objsec);
+            size_t          target_idx = objsec->os_shdr.sh_info;
+            ezld_obj_sec_t *target     = NULL;
+
+            if (target_idx < obj->obj_oss.len) {
+                target = &obj->obj_oss.buf[target_idx];
+            }
+
+            if (target != NULL && target->os_mrg != NULL &&
+                target->os_mrgsyn == NULL && is_debug_section(target->os_mrg)) {
+                defer_relocs(objsec);
+            } else {
                 rela_section(objsec);
             }
         }
@@ -1486,24 +6308,137 @@ static void apply_relocations(void) {
 void ezld_link(ezld_config_t config) {
     ezld_instance_t instance = {0};
     ezld_array_init(instance.i_mss);
+    ezld_array_init(instance.i_segs);
+    ezld_array_init(instance.i_synthsecs);
+    ezld_array_init(instance.i_mrgsyns);
+    ezld_array_init(instance.i_thunks);
+    ezld_htab_init(instance.i_comdats);
     ezld_array_init(instance.i_globsymtab);
     ezld_array_init(instance.i_globstrtab.gst_strs);
     ezld_array_init(instance.i_shstrtab.gst_strs);
-    instance.i_osentry = NULL;
-    instance.i_cfg     = config;
-    instance.i_out     = (ezld_output_t){0};
+    ezld_array_init(instance.i_ownedstrs);
+    instance.i_osentry    = NULL;
+    instance.i_symhash    = NULL;
+    instance.i_symhashlen = 0;
+    instance.i_unpack     = NULL;
+    instance.i_copytable  = NULL;
+    instance.i_ncopies    = 0;
+    instance.i_dynamic    = NULL;
+    instance.i_relrdyn    = NULL;
+    ezld_array_init(instance.i_relrs);
+    instance.i_buildid    = NULL;
+    instance.i_cfg        = config;
+    instance.i_out        = (ezld_output_t){0};
+
+    instance.i_synthobj.obj_filepath = "<internal>";
+    instance.i_synthobj.obj_file     = NULL;
+    instance.i_synthobj.obj_ndx      = 0;
+    ezld_array_init(instance.i_synthobj.obj_oss);
+    ezld_array_init(instance.i_synthobj.obj_ost.ost_syms);
 
     g_self = &instance;
     globstr_add(instance.i_cfg.cfg_entrysym);
 
+    // The unpacking stub would inflate the image to its link-time address
+    if (config.cfg_staticpie && config.cfg_compress &&
+        !config.cfg_relocatable) {
+        ezld_runtime_exit(EZLD_ECODE_BADPARAM,
+                          "image compression can not be used for static "
+                          "PIEs");
+    }
+
     open_output();
     open_objects();
     setup_sections();
     read_objects();
-    align_sections();
-    virtualize_syms();
+    finalize_mergeables();
+    setup_symhash();
+    setup_copytable();
+    setup_dynamic();
+    setup_build_id();
+    read_symbol_ordering();
+    sort_call_graph();
+
+    if (instance.i_cfg.cfg_relocatable) {
+        if (instance.i_cfg.cfg_oformat != EZLD_OFORMAT_ELF) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "output format ignored for relocatable "
+                                 "output");
+        }
+
+        if (instance.i_cfg.cfg_compress) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "image compression ignored for relocatable "
+                                 "output");
+        }
+
+        if (instance.i_cfg.cfg_crcsym != NULL) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "image CRC ignored for relocatable output");
+        }
+
+        if (instance.i_cfg.cfg_staticpie) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "static PIE ignored for relocatable output");
+        }
+
+        if (instance.i_cfg.cfg_stripall) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "symbol table kept for relocatable output");
+        }
+
+        if (instance.i_cfg.cfg_buildid != EZLD_BUILD_ID_NONE) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "build ID ignored for relocatable output");
+        }
+
+        if (instance.i_cfg.cfg_compressdebug) {
+            ezld_runtime_message(EZLD_EMSG_WARN,
+                                 "debug section compression ignored for "
+                                 "relocatable output");
+        }
+
+        layout_sections();
+        write_rel();
+    } else {
+        layout_output();
+        write_symhash();
+        write_copytable();
+        write_dynamic();
+        apply_relocations();
+
+        // The copy table and the image CRC describe the file contents of the
+        // segments as they are, and compressed segments have none left, so
+        // trimming is only done without them. It comes before the build ID,
+        // which covers the file contents too
+        if (instance.i_cfg.cfg_oformat == EZLD_OFORMAT_ELF &&
+            instance.i_copytable == NULL && instance.i_cfg.cfg_crcsym == NULL &&
+            !instance.i_cfg.cfg_compress) {
+            trim_segments();
+        }
+
+        if (instance.i_buildid != NULL) {
+            write_build_id();
+        }
+
+        if (instance.i_cfg.cfg_crcsym != NULL) {
+            write_image_crc();
+        }
+
+        if (instance.i_cfg.cfg_compress) {
+            compress_segments();
+        }
+
+        if (instance.i_cfg.cfg_oformat == EZLD_OFORMAT_ELF) {
+            if (instance.i_cfg.cfg_compressdebug) {
+                compress_debug_sections();
+            }
+
+            write_exec();
+        } else {
+            write_image();
+        }
+    }
 
-    write_exec();
-    apply_relocations();
     free_instance();
 }
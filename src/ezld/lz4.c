@@ -0,0 +1,172 @@
+// MIT License
+//
+// Copyright (c) 2025 - 2026 Alessandro Salerno
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <ezld/lz4.h>
+#include <ezld/runtime.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// LZ4 block format limits: matches are 4 bytes or longer and reach at most
+// 64 KiB back, the last match starts at least 12 bytes before the end of the
+// block, and the last 5 bytes are always literals
+#define EZLD_LZ4_MIN_MATCH     4
+#define EZLD_LZ4_MAX_OFFSET    0xFFFF
+#define EZLD_LZ4_MF_LIMIT      12
+#define EZLD_LZ4_LAST_LITERALS 5
+#define EZLD_LZ4_HASH_BITS     12
+
+/**
+ * @param len the size of the data to compress
+ *
+ * @return the maximum size of the LZ4 block holding `len` bytes
+ */
+size_t ezld_lz4_bound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+/**
+ * @brief Writes the extra bytes of a literal or match length that does not fit
+ * in its 4-bit field of the token
+ *
+ * @param dst the destination buffer
+ * @param len the length minus 15
+ *
+ * @return the number of bytes written
+ */
+static size_t lz4_put_len(uint8_t *dst, size_t len) {
+    size_t n = 0;
+
+    for (; len >= 255; len -= 255) {
+        dst[n++] = 255;
+    }
+
+    dst[n++] = len;
+    return n;
+}
+
+/**
+ * @brief Writes an LZ4 sequence: a run of literals followed by a match, if any
+ *
+ * @param dst the destination buffer
+ * @param lit the literals
+ * @param litlen the number of literals
+ * @param offset the distance of the match
+ * @param matchlen the length of the match, or 0 for the last sequence
+ *
+ * @return the number of bytes written
+ */
+static size_t lz4_put_seq(uint8_t       *dst,
+                          const uint8_t *lit,
+                          size_t         litlen,
+                          size_t         offset,
+                          size_t         matchlen) {
+    size_t   n     = 1;
+    size_t   mlen  = matchlen ? matchlen - EZLD_LZ4_MIN_MATCH : 0;
+    uint8_t *token = dst;
+    *token         = ((litlen < 15) ? litlen : 15) << 4;
+
+    if (litlen >= 15) {
+        n += lz4_put_len(&dst[n], litlen - 15);
+    }
+
+    memcpy(&dst[n], lit, litlen);
+    n += litlen;
+
+    if (matchlen == 0) {
+        return n;
+    }
+
+    *token |= (mlen < 15) ? mlen : 15;
+    dst[n++] = offset & 0xFF;
+    dst[n++] = offset >> 8;
+
+    if (mlen >= 15) {
+        n += lz4_put_len(&dst[n], mlen - 15);
+    }
+
+    return n;
+}
+
+/**
+ * @param p the data
+ *
+ * @return the hash of the first 4 bytes of `p`, which are read in little endian
+ * order so that the output does not depend on the host
+ */
+static size_t lz4_hash(const uint8_t *p) {
+    uint32_t seq = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+    return (seq * 2654435761U) >> (32 - EZLD_LZ4_HASH_BITS);
+}
+
+/**
+ * @brief Compresses data to an LZ4 block with a greedy parser that looks up the
+ * last position where each 4-byte sequence was seen
+ *
+ * @param dst the destination buffer, at least `ezld_lz4_bound(len)` bytes long
+ * @param src the data to compress
+ * @param len the size of the data
+ *
+ * @return the size of the LZ4 block
+ */
+size_t ezld_lz4_compress(uint8_t *dst, const uint8_t *src, size_t len) {
+    // Positions are stored plus one, so that 0 means unseen
+    size_t  tabsz  = sizeof(size_t) << EZLD_LZ4_HASH_BITS;
+    size_t *table  = ezld_runtime_alloc(1, tabsz);
+    size_t  anchor = 0;
+    size_t  ip     = 0;
+    size_t  n      = 0;
+    memset(table, 0, tabsz);
+
+    while (ip + EZLD_LZ4_MF_LIMIT <= len) {
+        size_t h   = lz4_hash(&src[ip]);
+        size_t ref = table[h];
+        table[h]   = ip + 1;
+
+        if (ref == 0 || ip - (ref - 1) > EZLD_LZ4_MAX_OFFSET ||
+            memcmp(&src[ref - 1], &src[ip], EZLD_LZ4_MIN_MATCH) != 0) {
+            ip++;
+            continue;
+        }
+
+        size_t match = ref - 1;
+        while (ip > anchor && match > 0 && src[ip - 1] == src[match - 1]) {
+            ip--;
+            match--;
+        }
+
+        size_t mlen = EZLD_LZ4_MIN_MATCH;
+        while (ip + mlen < len - EZLD_LZ4_LAST_LITERALS &&
+               src[ip + mlen] == src[match + mlen]) {
+            mlen++;
+        }
+
+        n += lz4_put_seq(
+            &dst[n], &src[anchor], ip - anchor, ip - match, mlen);
+        ip += mlen;
+        anchor = ip;
+    }
+
+    n += lz4_put_seq(&dst[n], &src[anchor], len - anchor, 0, 0);
+    free(table);
+    return n;
+}
@@ -22,9 +22,17 @@
 
 #include <ezld/runtime.h>
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+// C11 threads are optional, and fuzzing wants deterministic single-threaded
+// runs, so `ezld_runtime_parallel_for` falls back to a plain loop
+#if !defined(__STDC_NO_THREADS__) && !defined(EXT_EZLD_FUZZER)
+#include <threads.h>
+#define EZLD_RUNTIME_THREADS 8
+#endif
+
 static int          g_argc;
 static const char **g_argv;
 
@@ -147,3 +155,181 @@ bool ezld_runtime_is_big_endian(void) {
     int i = 1;
     return !*((char *)&i);
 }
+
+char *ezld_runtime_read_file(const char *filename, size_t *size) {
+    FILE *file = fopen(filename, "rb");
+
+    if (file == NULL) {
+        ezld_runtime_exit(
+            EZLD_ECODE_NOFILE, "could not open input file '%s'", filename);
+    }
+
+    ezld_runtime_seek_end(filename, file);
+    long end = ftell(file);
+
+    if (end < 0) {
+        ezld_runtime_exit(
+            EZLD_ECODE_BADFILE, "unable to find end of '%s'", filename);
+    }
+
+    // The buffer is null-terminated for the convenience of text parsers
+    char *buf = ezld_runtime_alloc(1, (size_t)end + 1);
+    ezld_runtime_seek(0, filename, file);
+    ezld_runtime_read_exact(buf, (size_t)end, filename, file);
+    buf[end] = '\0';
+    fclose(file);
+
+    *size = (size_t)end;
+    return buf;
+}
+
+/**
+ * @brief Matches a character against a bracket expression such as `[a-z]` or
+ * `[!0-9]`, advancing the pattern past the expression
+ */
+static bool glob_class_match(const char **pattern, char c) {
+    const char *p       = *pattern + 1;
+    bool        negated = false;
+    bool        matched = false;
+
+    if (*p == '!' || *p == '^') {
+        negated = true;
+        p++;
+    }
+
+    // A ']' right after the opening bracket is part of the class
+    do {
+        if (*p == '\0') {
+            // Unterminated class, the bracket is matched literally
+            *pattern += 1;
+            return c == '[';
+        }
+
+        if (p[1] == '-' && p[2] != ']' && p[2] != '\0') {
+            matched = matched || (c >= p[0] && c <= p[2]);
+            p += 3;
+        } else {
+            matched = matched || c == *p;
+            p++;
+        }
+    } while (*p != ']');
+
+    *pattern = p + 1;
+    return matched != negated;
+}
+
+bool ezld_runtime_glob_match(const char *pattern, const char *str) {
+    const char *star_pattern = NULL;
+    const char *star_str     = NULL;
+
+    while (*str != '\0') {
+        const char *next    = pattern + 1;
+        bool        matched = false;
+
+        if (*pattern == '*') {
+            star_pattern = next;
+            star_str     = str;
+            pattern      = next;
+            continue;
+        }
+
+        if (*pattern == '?') {
+            matched = true;
+        } else if (*pattern == '[') {
+            next    = pattern;
+            matched = glob_class_match(&next, *str);
+        } else {
+            matched = *pattern == *str;
+        }
+
+        if (matched) {
+            pattern = next;
+            str++;
+            continue;
+        }
+
+        // Let the last '*' consume one more character and retry
+        if (star_pattern == NULL) {
+            return false;
+        }
+
+        pattern = star_pattern;
+        str     = ++star_str;
+    }
+
+    while (*pattern == '*') {
+        pattern++;
+    }
+
+    return *pattern == '\0';
+}
+
+/**
+ * @brief A share of the iterations of `ezld_runtime_parallel_for`: those whose
+ * index is `pj_first` plus a multiple of `pj_stride`
+ */
+typedef struct parallel_job {
+    void (*pj_fn)(void *ctx, size_t ndx);
+    void  *pj_ctx;
+    size_t pj_first;
+    size_t pj_stride;
+    size_t pj_num;
+} parallel_job_t;
+
+static int parallel_worker(void *arg) {
+    parallel_job_t *job = arg;
+
+    for (size_t i = job->pj_first; i < job->pj_num; i += job->pj_stride) {
+        job->pj_fn(job->pj_ctx, i);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Calls a function for every index in [0, num), spreading the calls
+ * over multiple threads where available. The calls must be independent of
+ * each other, and the function must not exit
+ *
+ * @param num the number of iterations
+ * @param fn the function, which receives the context and the index
+ * @param ctx the context passed to the function
+ */
+void ezld_runtime_parallel_for(size_t num,
+                               void (*fn)(void *ctx, size_t ndx),
+                               void  *ctx) {
+#ifdef EZLD_RUNTIME_THREADS
+    parallel_job_t jobs[EZLD_RUNTIME_THREADS];
+    thrd_t         threads[EZLD_RUNTIME_THREADS];
+    bool           started[EZLD_RUNTIME_THREADS] = {false};
+    size_t         nthreads =
+        (num < EZLD_RUNTIME_THREADS) ? num : EZLD_RUNTIME_THREADS;
+
+    for (size_t t = 0; t < nthreads; t++) {
+        jobs[t] = (parallel_job_t){.pj_fn     = fn,
+                                   .pj_ctx    = ctx,
+                                   .pj_first  = t,
+                                   .pj_stride = nthreads,
+                                   .pj_num    = num};
+    }
+
+    // The calling thread takes the first share, and any share whose thread
+    // could not be started
+    for (size_t t = 1; t < nthreads; t++) {
+        started[t] = thrd_create(&threads[t], parallel_worker, &jobs[t]) ==
+                     thrd_success;
+    }
+
+    for (size_t t = 0; t < nthreads; t++) {
+        if (started[t]) {
+            (void)thrd_join(threads[t], NULL);
+        } else {
+            (void)parallel_worker(&jobs[t]);
+        }
+    }
+#else
+    for (size_t i = 0; i < num; i++) {
+        fn(ctx, i);
+    }
+#endif
+}
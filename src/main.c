@@ -35,6 +35,9 @@ int main(int argc, const char *argv[]) {
     cfg.cfg_segalign = 0x1000;
     ezld_array_init(cfg.cfg_objpaths);
     ezld_array_init(cfg.cfg_sections);
+    ezld_array_init(cfg.cfg_loadaddrs);
+    ezld_array_init(cfg.cfg_secmaps);
+    ezld_array_init(cfg.cfg_discards);
     *ezld_array_push(cfg.cfg_sections) =
         (ezld_sec_cfg_t){.sc_name = ".text", .sc_vaddr = 0x00400000};
     *ezld_array_push(cfg.cfg_sections) =
@@ -47,6 +50,9 @@ int main(int argc, const char *argv[]) {
 
     ezld_array_free(cfg.cfg_objpaths);
     ezld_array_free(cfg.cfg_sections);
+    ezld_array_free(cfg.cfg_loadaddrs);
+    ezld_array_free(cfg.cfg_secmaps);
+    ezld_array_free(cfg.cfg_discards);
     return EXIT_SUCCESS;
 }
 #endif
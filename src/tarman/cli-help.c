@@ -46,6 +46,10 @@ static size_t find_line_len(cli_drt_desc_t desc) {
         cmd_len += strlen(desc.full_option);
     }
 
+    if (desc.short_option != NULL && desc.full_option != NULL) {
+        cmd_len += OPT_SEPARATOR_LEN;
+    }
+
     return cmd_len;
 }
 
@@ -46,18 +46,155 @@ static cli_drt_desc_t options[] = {
      NULL,
      "set the base virtual address for a given section (example: -s "
      ".text=0x4000)"},
+    {NULL,
+     "--load-address",
+     ezld_clicmd_loadaddr,
+     true,
+     NULL,
+     "load a section at a different address than the one it runs at, and "
+     "generate copy and zero tables (example: --load-address "
+     ".data=0x20004000)"},
+    {NULL,
+     "--section-map",
+     ezld_clicmd_secmap,
+     true,
+     NULL,
+     "fold input sections matching a glob into an output section (example: "
+     "--section-map '.text.*=.text')"},
     {"-a",
      "--align",
      ezld_clicmd_align,
      true,
      NULL,
      "set the alignent of PT_LOAD segments (default: 0x1000)"},
+    {NULL,
+     "--sort-by-alignment",
+     ezld_clicmd_sortalign,
+     false,
+     NULL,
+     "place input sections with larger alignments first to reduce padding"},
+    {NULL,
+     "--compact-layout",
+     ezld_clicmd_compact,
+     false,
+     NULL,
+     "only align PT_LOAD segments in the file as required by their address"},
+    {NULL,
+     "--headers-in-load",
+     ezld_clicmd_hdrload,
+     false,
+     NULL,
+     "load the ELF and program headers as part of the first PT_LOAD segment"},
+    {"-r",
+     "--relocatable",
+     ezld_clicmd_relocatable,
+     false,
+     NULL,
+     "produce a relocatable object file instead of an executable"},
+    {"-q",
+     "--emit-relocs",
+     ezld_clicmd_emitrelocs,
+     false,
+     NULL,
+     "keep relocations in the executable for post-link optimizers"},
+    {"-x",
+     "--discard-all",
+     ezld_clicmd_discardall,
+     false,
+     NULL,
+     "leave local symbols out of the symbol table of the executable"},
+    {"-S",
+     "--strip-debug",
+     ezld_clicmd_stripdebug,
+     false,
+     NULL,
+     "drop debugging sections (.debug_*, .zdebug_*, .line, .stab*)"},
+    {NULL,
+     "--strip-all",
+     ezld_clicmd_stripall,
+     false,
+     NULL,
+     "drop all non-allocated sections and the symbol table"},
+    {NULL,
+     "--discard-section",
+     ezld_clicmd_discardsec,
+     true,
+     NULL,
+     "drop input sections matching a glob (example: --discard-section "
+     "'.comment')"},
+    {NULL,
+     "--symbol-hash",
+     ezld_clicmd_symhash,
+     false,
+     NULL,
+     "add a loaded GNU-style hash table of the global symbols (.symhash)"},
+    {"-static-pie",
+     "--static-pie",
+     ezld_clicmd_staticpie,
+     false,
+     NULL,
+     "produce a position-independent executable that relocates itself using "
+     "packed relative relocations (.relr.dyn)"},
+    {NULL,
+     "--oformat",
+     ezld_clicmd_oformat,
+     true,
+     NULL,
+     "set the output format: elf (default), binary, ihex, or srec"},
+    {NULL,
+     "--compress-image",
+     ezld_clicmd_compress,
+     true,
+     NULL,
+     "LZ4-compress the loadable segments and unpack them at run time from a "
+     "stub placed at the given address (example: --compress-image "
+     "0x20000000)"},
+    {NULL,
+     "--image-crc",
+     ezld_clicmd_imagecrc,
+     true,
+     NULL,
+     "store a CRC32 of the loadable segments in a symbol (example: "
+     "--image-crc image_crc=crc32c)"},
+    {NULL,
+     "--build-id",
+     ezld_clicmd_buildid,
+     true,
+     NULL,
+     "emit a .note.gnu.build-id section: fast (XXH64), sha1, uuid, or "
+     "none (example: --build-id sha1)"},
+    {NULL,
+     "--compress-debug-sections",
+     ezld_clicmd_compressdebug,
+     true,
+     NULL,
+     "zlib-compress the .debug* sections of the output: zlib or none "
+     "(example: --compress-debug-sections zlib)"},
     {"-o",
      "--output",
      ezld_clicmd_output,
      true,
      NULL,
-     "set the output file path (default: 'a.out')"}};
+     "set the output file path (default: 'a.out')"},
+    {NULL,
+     "--symbol-ordering-file",
+     ezld_clicmd_symorder,
+     true,
+     NULL,
+     "lay out sections in the order of the symbols listed in a file"},
+    {NULL,
+     "--call-graph-sort",
+     ezld_clicmd_cgsort,
+     false,
+     NULL,
+     "lay out code sections so that callers and callees are close"},
+    {NULL,
+     "--call-graph-profile",
+     ezld_clicmd_cgprofile,
+     true,
+     NULL,
+     "weigh calls for --call-graph-sort using a file of '<caller> <callee> "
+     "<count>' lines"}};
 
 static bool find_desc(cli_drt_desc_t  descriptors[],
                       size_t          num_desc,